@@ -41,7 +41,8 @@ local defaultOptions = {
     forceEffectOptimization = false,
     drawEffectOnTop = false,
     floorViewMode = 1,
-    floorFading = 500
+    floorFading = 500,
+    cacheSpriteSheets = false
 }
 
 local optionsWindow
@@ -267,6 +268,8 @@ function setOption(key, value, force)
         gameMapPanel:setLimitVisibleDimension(value)
     elseif key == 'floatingEffect' then
         g_map.setFloatingEffect(value)
+    elseif key == 'cacheSpriteSheets' then
+        g_spriteAppearances.setSheetDiskCacheEnabled(value)
     elseif key == 'displayNames' then
         gameMapPanel:setDrawNames(value)
     elseif key == 'displayHealth' then
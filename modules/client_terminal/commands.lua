@@ -178,3 +178,307 @@ function about_modules()
         end
     end
 end
+
+-- the first call starts collecting, later calls print what was measured since then
+function opcode_stats(limit)
+    if not g_opcodeStats.isEnabled() then
+        g_opcodeStats.setEnabled(true)
+        pcolored('opcode stats enabled, run opcode_stats again to see them')
+        return
+    end
+
+    for line in g_opcodeStats.dump(limit or 20):gmatch('[^\n]+') do
+        pcolored(line)
+    end
+end
+
+function opcode_stats_reset()
+    g_opcodeStats.reset()
+end
+
+function opcode_stats_stop()
+    g_opcodeStats.setEnabled(false)
+end
+
+function slow_packet_threshold(millis)
+    g_opcodeStats.setSlowThreshold(millis or 0)
+    if (millis or 0) > 0 then
+        g_opcodeStats.setEnabled(true)
+    end
+end
+
+local loadTestSessions = {}
+local loadTestEvent = nil
+
+-- logs in count headless sessions named prefix1..prefixN, each one with an account of the same name,
+-- and makes them walk around and talk until load_test_stop is called
+function load_test_start(count, host, port, prefix, password)
+    if not count or not host or not port or not prefix then
+        pcolored('usage: load_test_start(count, host, port, prefix, password)', 'red')
+        return
+    end
+
+    for i = 1, count do
+        local name = prefix .. i
+        local session = ProtocolGame.create()
+        session:setHeadless(true)
+        session.onError = function(self, message)
+            pcolored(name .. ': ' .. message, 'red')
+        end
+        session:login(name, password or '', host, port, name, '', '')
+        table.insert(loadTestSessions, session)
+    end
+
+    -- headless sessions miss server pings batched behind other opcodes, so they ping on their own
+    local walks = { 'sendWalkNorth', 'sendWalkEast', 'sendWalkSouth', 'sendWalkWest' }
+    local ticks = 0
+    loadTestEvent = cycleEvent(function()
+        ticks = ticks + 1
+        for _, session in ipairs(loadTestSessions) do
+            if session:isConnected() then
+                local action = math.random(1, 10)
+                if action <= 6 then
+                    session[walks[math.random(1, #walks)]](session)
+                elseif action == 7 then
+                    session:sendTalk(MessageModes.Say, 0, '', 'load test ' .. math.random(1, 1000))
+                end
+                if ticks % 10 == 0 then
+                    session:sendPing()
+                end
+            end
+        end
+    end, 1000)
+
+    pcolored('started ' .. count .. ' sessions, ' .. #loadTestSessions .. ' running', 'green')
+end
+
+function load_test_stop()
+    removeEvent(loadTestEvent)
+    loadTestEvent = nil
+
+    for _, session in ipairs(loadTestSessions) do
+        if session:isConnected() then
+            session:sendLogout()
+        end
+        session:disconnect()
+    end
+    loadTestSessions = {}
+end
+
+function tile_lookup_benchmark(iterations)
+    local result = g_map.benchmarkTileLookup(iterations or 1000)
+    pcolored(string.format('%d lookups, %d tiles found', result.lookups, result.tilesFound))
+    pcolored(string.format('blocks: %.2f ns/lookup, grid: %.2f ns/lookup (%.2fx)',
+        result.blockNanosPerLookup, result.gridNanosPerLookup, result.speedup))
+end
+
+function tile_analysis_benchmark(iterations)
+    local result = g_map.benchmarkTileAnalysis(iterations or 1000)
+    pcolored(string.format('%d things in view', result.things))
+    pcolored(string.format('thing types: %.2f ns/thing, flag tables: %.2f ns/thing (%.2fx)',
+        result.typeNanosPerThing, result.tableNanosPerThing, result.speedup), result.matches == 1 and 'white' or 'red')
+end
+
+function find_path_benchmark(iterations, maxComplexity)
+    local result = g_map.benchmarkFindPath(iterations or 10, maxComplexity or 50000)
+    pcolored(string.format('%d routes, %d found', result.routes, result.found))
+    pcolored(string.format('reference: %.2f us/route, grid A*: %.2f us/route, jump points: %.2f us/route',
+        result.referenceMicrosPerRoute, result.gridMicrosPerRoute, result.jumpPointMicrosPerRoute))
+    pcolored(string.format('mismatches: grid A* %d, jump points %d', result.gridMismatches, result.jumpPointMismatches),
+        (result.gridMismatches == 0 and result.jumpPointMismatches == 0) and 'white' or 'red')
+end
+
+function path_find_stats(reset)
+    local stats = g_map.getPathFindStats()
+    pcolored(string.format('%d workers, %d requests, %d completed, %d canceled, %d pending',
+        stats.workers, stats.requests, stats.completed, stats.canceled, stats.pending))
+    pcolored(string.format('latency: queue %.2f ms, search %.2f ms, total %.2f ms avg, %.2f ms max',
+        stats.avgQueueTime, stats.avgSearchTime, stats.avgTotalTime, stats.maxTotalTime))
+    if reset then
+        g_map.resetPathFindStats()
+    end
+end
+
+function path_cache_stats(reset)
+    local stats = g_map.getPathCacheStats()
+    pcolored(string.format('%d entries, %d hits, %d misses (%.1f%% hit rate), %d invalidated',
+        stats.entries, stats.hits, stats.misses, stats.hitRate * 100, stats.invalidated))
+    if reset then
+        g_map.resetPathCacheStats()
+    end
+end
+
+function texture_atlas_stats(reset)
+    local stats = g_things.getTextureAtlasStats()
+    pcolored(string.format('atlas %s, %d/%d pages of %dpx (%.1f%% used), %d regions, %d evictions, %d rejections',
+        stats.enabled == 1 and 'on' or 'off', stats.pages, stats.maxPages, stats.pageSize, stats.usage * 100,
+        stats.regions, stats.evictions + stats.releases, stats.rejections))
+    pcolored(string.format('last frame: %d draw calls, %d texture changes', g_graphics.getDrawCalls(),
+        g_graphics.getTextureChanges()))
+    if reset then
+        g_things.resetTextureAtlasStats()
+    end
+end
+
+function texture_composer_stats(reset)
+    local stats = g_things.getTextureComposerStats()
+    pcolored(string.format('composer %s, %d workers, %d queued, %d requests, %d composed, %d failed',
+        stats.enabled == 1 and 'on' or 'off', stats.workers, stats.queued, stats.requests, stats.composed, stats.failed))
+    pcolored(string.format('wait %.2f ms avg, %.2f ms max, compose %.2f ms avg', stats.avgWaitTime, stats.maxWaitTime,
+        stats.avgComposeTime))
+    if reset then
+        g_things.resetTextureComposerStats()
+    end
+end
+
+function texture_memory_stats(reset)
+    local stats = g_textures.getMemoryStats()
+    local budget = stats.budget > 0 and string.format('%.1f MiB', stats.budget / 1048576) or 'none'
+    pcolored(string.format('textures use %.1f MiB, budget %s, freed after %d s idle', stats.usage / 1048576, budget,
+        stats.idleTime / 1000))
+    pcolored(string.format('%d cached files, %d evictions', stats.cachedTextures, stats.evictions))
+    if reset then
+        g_textures.resetMemoryStats()
+    end
+end
+
+function sprite_sheet_stats(reset)
+    local stats = g_spriteAppearances.getSheetCacheStats()
+    local size = stats.size > 0 and string.format('%.1f MiB', stats.size / 1048576) or 'unlimited'
+    pcolored(string.format('%d/%d sheets decoded, %.1f MiB of %s', stats.loadedSheets, stats.sheets,
+        stats.usage / 1048576, size))
+    pcolored(string.format('%d hits, %d misses, %d decodes (%.2f ms avg), %d evictions', stats.hits, stats.misses,
+        stats.decodes, stats.avgDecodeTime, stats.evictions))
+    pcolored(string.format('disk cache %s, %d loads (%.2f ms avg), %d writes', stats.diskCache == 1 and 'on' or 'off',
+        stats.diskLoads, stats.avgDiskLoadTime, stats.diskWrites))
+    if reset then
+        g_spriteAppearances.resetSheetCacheStats()
+    end
+end
+
+-- encrypts and decrypts the same buffer with every xtea kernel the cpu supports
+function xtea_benchmark(bytes, iterations)
+    local result = g_game.benchmarkXtea(bytes or 65536, iterations or 1000)
+    pcolored(string.format('kernel in use: %s, %d bytes x %d iterations', g_game.getXteaKernel(), result.bytes,
+        result.iterations))
+    for _, kernel in ipairs({ 'scalar', 'sse2', 'avx2' }) do
+        local speed = result[kernel .. 'MBps']
+        if speed then
+            pcolored(string.format('%s: %.1f MB/s', kernel, speed))
+        end
+    end
+    pcolored(result.roundTrip == 1 and 'round trip: ok' or 'round trip: MISMATCH', result.roundTrip == 1 and 'white' or 'red')
+end
+
+function sprite_sheet_benchmark(lookups)
+    local stats = g_spriteAppearances.benchmarkSheetLookup(lookups or 100000)
+    if not stats.lookups then
+        pcolored('no sprite sheets loaded', 'red')
+        return
+    end
+    pcolored(string.format('%d lookups over %d sheets: scan %.1f ns, index %.1f ns', stats.lookups, stats.sheets,
+        stats.scanTime, stats.indexTime))
+end
+
+-- runs the game handshake over a loopback connection: a plaintext challenge, a login after which
+-- both sides enable encryption, then encrypted frames that must decode, the network thread build
+-- reads ahead of the main thread so the encryption must apply from the frame after the login
+function network_handshake_test(port)
+    port = port or 7399
+    local server = Server.create(port)
+    if not server then
+        pcolored('unable to listen on port ' .. port, 'red')
+        return
+    end
+
+    local key = { 0x01234567, 0x89ABCDEF, 0xFEDCBA98, 0x76543210 }
+    local markers = { 0x5A17C0DE, 0x0DDBA11 }
+    local client = Protocol.create()
+    local serverProtocol = nil
+    local stage = 'connect'
+    local timeoutEvent = nil
+
+    local function finish(passed, text)
+        if stage == 'done' then return end
+        stage = 'done'
+        removeEvent(timeoutEvent)
+        pcolored(text, passed and 'green' or 'red')
+        client:disconnect()
+        if serverProtocol then
+            serverProtocol:disconnect()
+        end
+        server:close()
+    end
+
+    server.onAccept = function(self, connection, errorMessage, errorValue)
+        if errorValue ~= 0 then
+            finish(false, 'accept failed: ' .. errorMessage)
+            return
+        end
+
+        serverProtocol = Protocol.create()
+        serverProtocol:setConnection(connection)
+        serverProtocol:enableChecksum()
+        serverProtocol.onRecv = function(self, msg)
+            if msg:getU32() ~= key[1] then
+                finish(false, 'server received a wrong login')
+                return
+            end
+            self:setXteaKey(key[1], key[2], key[3], key[4])
+            self:enableXteaEncryption()
+            for _, marker in ipairs(markers) do
+                local reply = OutputMessage.create()
+                reply:addU32(marker)
+                self:send(reply)
+            end
+        end
+        serverProtocol.onError = function(self, message)
+            finish(false, 'server error at ' .. stage .. ': ' .. message)
+        end
+
+        local challenge = OutputMessage.create()
+        challenge:addU32(os.time())
+        serverProtocol:send(challenge)
+        serverProtocol:recv()
+    end
+    server:acceptNext()
+
+    local received = 0
+    client.onConnect = function(self)
+        stage = 'challenge'
+        self:enableChecksum()
+        self:recv()
+    end
+    client.onRecv = function(self, msg)
+        if stage == 'challenge' then
+            -- like ProtocolGame, the key is sent in the login and only then encryption is enabled
+            stage = 'encrypted'
+            self:setXteaKey(key[1], key[2], key[3], key[4])
+            local login = OutputMessage.create()
+            login:addU32(key[1])
+            self:send(login)
+            self:enableXteaEncryption()
+            self:recv()
+            return
+        end
+
+        received = received + 1
+        local value = msg:getU32()
+        if value ~= markers[received] then
+            finish(false, string.format('encrypted frame %d decoded as %08x instead of %08x', received, value,
+                markers[received]))
+        elseif received == #markers then
+            finish(true, 'handshake passed, ' .. received .. ' encrypted frames decoded')
+        else
+            self:recv()
+        end
+    end
+    client.onError = function(self, message)
+        finish(false, 'client error at ' .. stage .. ': ' .. message)
+    end
+
+    timeoutEvent = scheduleEvent(function()
+        finish(false, 'timed out at ' .. stage)
+    end, 5000)
+    client:connect('127.0.0.1', port)
+end
@@ -154,6 +154,9 @@ GameIngameStoreServiceType = 75
 GameAdditionalSkills = 76
 GameDistanceEffectU16 = 77
 GamePrey = 82
+GamePacketCompression = 83
+GamePacketCompressionOutbound = 84
+GameCoalescedRecv = 85
 
 TextColors = {
     red = '#f55e5e', -- '#c83200'
@@ -269,7 +272,9 @@ PathFindFlags = {
     AllowNullTiles = 1,
     AllowCreatures = 2,
     AllowNonPathable = 4,
-    AllowNonWalkable = 8
+    AllowNonWalkable = 8,
+    IgnoreCreatures = 16,
+    JumpPoints = 32
 }
 
 VipState = {
@@ -4,12 +4,12 @@ local extendedJSONCallbacks = {}
 local extendedJSONData = {}
 local maxPacketSize = 65000
 
+-- only called for opcodes flagged with ProtocolGame.setOpcodeHooked
 function ProtocolGame:onOpcode(opcode, msg)
-    for i, callback in pairs(opcodeCallbacks) do
-        if i == opcode then
-            callback(self, msg)
-            return true
-        end
+    local callback = opcodeCallbacks[opcode]
+    if callback then
+        callback(self, msg)
+        return true
     end
     return false
 end
@@ -51,11 +51,19 @@ function ProtocolGame.registerOpcode(opcode, callback)
         error('opcode ' .. opcode .. ' already registered will be overriden')
     end
 
+    if opcode < 0 or opcode > 255 then
+        error('Invalid opcode. Range: 0-255')
+    end
+
     opcodeCallbacks[opcode] = callback
+    ProtocolGame.setOpcodeHooked(opcode, true)
 end
 
 function ProtocolGame.unregisterOpcode(opcode)
     opcodeCallbacks[opcode] = nil
+    if opcode >= 0 and opcode <= 255 then
+        ProtocolGame.setOpcodeHooked(opcode, false)
+    end
 end
 
 function ProtocolGame.registerExtendedOpcode(opcode, callback)
@@ -32,6 +32,14 @@
 Client g_client;
 
 void Client::init(std::vector<std::string>& /*args*/)
+{
+    initCore();
+
+    g_shaders.init();
+    g_sprites.init();
+}
+
+void Client::initCore()
 {
     // register needed lua functions
     registerLuaFunctions();
@@ -39,8 +47,6 @@ void Client::init(std::vector<std::string>& /*args*/)
     g_map.init();
     g_minimap.init();
     g_game.init();
-    g_shaders.init();
-    g_sprites.init();
     g_spriteAppearances.init();
     g_things.init();
 }
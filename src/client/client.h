@@ -28,6 +28,8 @@ class Client
 {
 public:
     static void init(std::vector<std::string>& args);
+    // everything but the shaders and the generated sprite textures, needs no graphics context
+    static void initCore();
     static void terminate();
     static void registerLuaFunctions();
 };
@@ -510,6 +510,9 @@ namespace Otc
         GameMapOldEffectRendering = 80,
         GameMapDontCorrectCorpse = 81,
         GamePrey = 82,
+        GamePacketCompression = 83,
+        GamePacketCompressionOutbound = 84,
+        GameCoalescedRecv = 85,
 
         LastGameFeature = 101
     };
@@ -539,7 +542,8 @@ namespace Otc
         PathFindAllowCreatures = 2,
         PathFindAllowNonPathable = 4,
         PathFindAllowNonWalkable = 8,
-        PathFindIgnoreCreatures = 16
+        PathFindIgnoreCreatures = 16,
+        PathFindJumpPoints = 32
     };
 
     enum AutomapFlags : uint8_t
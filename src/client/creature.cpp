@@ -186,6 +186,10 @@ void Creature::internalDrawOutfit(Point dest, float scaleFactor, bool animateWal
 
 void Creature::drawOutfit(const Rect& destRect, bool resize, const Color color)
 {
+    // the size is unknown until the composed texture of a new outfit arrives
+    if (m_sizeCache.exactSize == 0)
+        updateSizeCache();
+
     int frameSize;
     if (!resize)
         frameSize = m_sizeCache.frameSizeNotResized;
@@ -224,6 +228,9 @@ void Creature::drawInformation(const MapPosInfo& mapRect, const Point& dest, flo
     // calculate main rects
 
     const Size nameSize = m_nameCache.getTextSize();
+    if (ADJUST_CREATURE_INFORMATION_BASED_ON_CROP_SIZE && m_sizeCache.exactSize == 0)
+        updateSizeCache();
+
     const int cropSizeText = ADJUST_CREATURE_INFORMATION_BASED_ON_CROP_SIZE ? m_sizeCache.exactSize : 12,
         cropSizeBackGround = ADJUST_CREATURE_INFORMATION_BASED_ON_CROP_SIZE ? cropSizeText - nameSize.height() : 0;
 
@@ -694,15 +701,17 @@ void Creature::setOutfit(const Outfit& outfit)
 
     callLuaField("onOutfitChange", m_outfit, oldOutfit);
 
-    // Cache
-    {
-        if (m_outfit.getCategory() == ThingCategoryCreature)
-            m_sizeCache.exactSize = getExactSize();
-        else
-            m_sizeCache.exactSize = g_things.getThingType(m_outfit.getAuxId(), m_outfit.getCategory())->getExactSize();
+    updateSizeCache();
+}
 
-        m_sizeCache.frameSizeNotResized = std::max<int>(m_sizeCache.exactSize * 0.75f, 2 * SPRITE_SIZE * 0.75f);
-    }
+void Creature::updateSizeCache()
+{
+    if (m_outfit.getCategory() == ThingCategoryCreature)
+        m_sizeCache.exactSize = getExactSize();
+    else
+        m_sizeCache.exactSize = g_things.getThingType(m_outfit.getAuxId(), m_outfit.getCategory())->getExactSize();
+
+    m_sizeCache.frameSizeNotResized = std::max<int>(m_sizeCache.exactSize * 0.75f, 2 * SPRITE_SIZE * 0.75f);
 }
 
 void Creature::setOutfitColor(const Color& color, int duration)
@@ -229,6 +229,7 @@ protected:
     Timer m_jumpTimer;
 
 private:
+    // exactSize stays 0 while the outfit texture is being composed, it is retried on draw
     struct SizeCache { int exactSize{ 0 }, frameSizeNotResized{ 0 }; };
     struct StepCache
     {
@@ -242,6 +243,8 @@ private:
         uint64_t getDuration(Otc::Direction dir) { return Position::isDiagonal(dir) ? diagonalDuration : duration; }
     };
 
+    void updateSizeCache();
+
     StepCache m_stepCache;
     SizeCache m_sizeCache;
 
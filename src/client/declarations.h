@@ -52,6 +52,8 @@ class Town;
 class CreatureType;
 class Spawn;
 class TileBlock;
+class PathFindRequest;
+struct ComposedTexture;
 
 using MapViewPtr = stdext::shared_object_ptr<MapView>;
 using LightViewPtr = stdext::shared_object_ptr<LightView>;
@@ -75,6 +77,8 @@ using HousePtr = stdext::shared_object_ptr<House>;
 using TownPtr = stdext::shared_object_ptr<Town>;
 using CreatureTypePtr = stdext::shared_object_ptr<CreatureType>;
 using SpawnPtr = stdext::shared_object_ptr<Spawn>;
+using PathFindRequestPtr = std::shared_ptr<PathFindRequest>;
+using ComposedTexturePtr = std::shared_ptr<ComposedTexture>;
 
 using ThingList = std::vector<ThingPtr>;
 using ThingTypeList = std::vector<ThingTypePtr>;
@@ -30,6 +30,8 @@
 #include "protocolgame.h"
 #include <framework/core/application.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/net/packetrecorder.h>
+#include <framework/net/xtea.h>
 
 #include "framework/core/graphicalapplication.h"
 #include "tile.h"
@@ -45,6 +47,7 @@ void Game::terminate()
 {
     resetGameStates();
     m_protocolGame = nullptr;
+    stopRecording();
 }
 
 void Game::resetGameStates()
@@ -109,6 +112,11 @@ void Game::processConnectionError(const std::error_code& ec)
 
 void Game::processDisconnect()
 {
+    if (m_packetPlayer) {
+        m_packetPlayer->stop();
+        m_packetPlayer = nullptr;
+    }
+
     if (isOnline())
         processGameEnd();
 
@@ -514,6 +522,7 @@ void Game::loginWorld(const std::string_view account, const std::string_view pas
     m_localPlayer->setName(characterName);
 
     m_protocolGame = ProtocolGamePtr(new ProtocolGame);
+    m_protocolGame->setRecorder(m_packetRecorder);
     m_protocolGame->login(account, password, worldHost, static_cast<uint16_t>(worldPort), characterName, authenticatorToken, sessionKey);
     m_characterName = characterName;
     m_worldName = worldName;
@@ -545,6 +554,92 @@ void Game::safeLogout()
     m_protocolGame->sendLogout();
 }
 
+void Game::startRecording(const std::string_view fileName)
+{
+    stopRecording();
+
+    m_packetRecorder = PacketRecorder::create(std::string(fileName), m_clientVersion);
+    if (m_protocolGame && !m_packetPlayer)
+        m_protocolGame->setRecorder(m_packetRecorder);
+}
+
+void Game::stopRecording()
+{
+    if (!m_packetRecorder)
+        return;
+
+    if (m_protocolGame)
+        m_protocolGame->setRecorder(nullptr);
+
+    m_packetRecorder->close();
+    m_packetRecorder = nullptr;
+}
+
+PacketPlayerPtr Game::playRecording(const std::string_view fileName, float speed)
+{
+    if (m_protocolGame || isOnline())
+        throw Exception("Unable to play a recording while already online or logging.");
+
+    const auto player = PacketPlayer::create(std::string(fileName));
+    if (!player)
+        return nullptr;
+
+    startReplaySession(player);
+    m_packetPlayer->start(m_protocolGame, speed);
+    return player;
+}
+
+std::map<std::string, double> Game::benchmarkRecording(const std::string_view fileName, int iterations)
+{
+    if (m_protocolGame || isOnline())
+        throw Exception("Unable to benchmark a recording while already online or logging.");
+
+    const auto player = PacketPlayer::create(std::string(fileName));
+    if (!player)
+        return {};
+
+    // every iteration parses the whole session from a clean game state
+    std::map<std::string, double> total;
+    for (int i = 0; i < std::max<int>(iterations, 1); ++i) {
+        startReplaySession(player);
+        for (const auto& [name, value] : player->benchmark(m_protocolGame))
+            total[name] += value;
+        processDisconnect();
+    }
+
+    const double seconds = std::max<double>(total["seconds"], 1e-6);
+    total["messagesPerSecond"] = total["messages"] / seconds;
+    total["bytesPerSecond"] = total["bytes"] / seconds;
+    total["allocationsPerMessage"] = total["messages"] > 0 ? total["allocations"] / total["messages"] : 0;
+    total["iterations"] = std::max<int>(iterations, 1);
+    return total;
+}
+
+std::string Game::getXteaKernel() { return xtea::getKernelName(); }
+
+std::map<std::string, double> Game::benchmarkXtea(uint32_t bytes, uint32_t iterations) { return xtea::benchmark(bytes, iterations); }
+
+void Game::startReplaySession(const PacketPlayerPtr& player)
+{
+    if (player->getClientVersion() != m_clientVersion)
+        throw Exception("Recording was made with client version %d, current is %d.", player->getClientVersion(), m_clientVersion);
+
+    resetGameStates();
+
+    m_localPlayer = LocalPlayerPtr(new LocalPlayer);
+
+    m_protocolGame = ProtocolGamePtr(new ProtocolGame);
+    m_protocolGame->startReplay();
+
+    m_packetPlayer = player;
+}
+
+void Game::stopPlayback()
+{
+    if (m_packetPlayer)
+        processDisconnect();
+}
+
 bool Game::walk(const Otc::Direction direction, bool isKeyDown /*= false*/)
 {
     if (!canPerformGameAction())
@@ -162,6 +162,19 @@ public:
     void forceLogout();
     void safeLogout();
 
+    // session capture, see PacketRecorder
+    void startRecording(const std::string_view fileName);
+    void stopRecording();
+    bool isRecording() { return m_packetRecorder != nullptr; }
+    PacketPlayerPtr playRecording(const std::string_view fileName, float speed);
+    void stopPlayback();
+    std::map<std::string, double> benchmarkRecording(const std::string_view fileName, int iterations);
+    bool isPlayingBack() { return m_packetPlayer != nullptr; }
+
+    // game message encryption, see xtea::benchmark
+    std::string getXteaKernel();
+    std::map<std::string, double> benchmarkXtea(uint32_t bytes, uint32_t iterations);
+
     // walk related
     bool walk(Otc::Direction direction, bool isKeyDown = false);
     void autoWalk(std::vector<Otc::Direction> dirs, Position startPos);
@@ -380,11 +393,14 @@ protected:
 private:
     void setAttackingCreature(const CreaturePtr& creature);
     void setFollowingCreature(const CreaturePtr& creature);
+    void startReplaySession(const PacketPlayerPtr& player);
 
     LocalPlayerPtr m_localPlayer;
     CreaturePtr m_attackingCreature;
     CreaturePtr m_followingCreature;
     ProtocolGamePtr m_protocolGame;
+    PacketRecorderPtr m_packetRecorder;
+    PacketPlayerPtr m_packetPlayer;
     std::map<int, ContainerPtr> m_containers;
     std::map<int, Vip> m_vips;
 
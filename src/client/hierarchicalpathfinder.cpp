@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "hierarchicalpathfinder.h"
+
+#include <queue>
+
+namespace
+{
+    bool isWalkable(const MinimapTile& tile)
+    {
+        return tile.hasFlag(MinimapTileWasSeen) && !(tile.flags & (MinimapTileNotWalkable | MinimapTileNotPathable | MinimapTileEmpty));
+    }
+
+    // east, west, south and north, in the order of Cluster::versions
+    constexpr int borders[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+}
+
+Otc::PathFindResult HierarchicalPathFinder::findRoute(const Position& start, const Position& goal, std::vector<Position>& waypoints)
+{
+    std::lock_guard lock(m_mutex);
+
+    waypoints.clear();
+    if (start == goal)
+        return Otc::PathFindResultSamePosition;
+    if (start.z != goal.z)
+        return Otc::PathFindResultImpossible;
+
+    // clusters are checked against the minimap once per route
+    if (++m_route == 0)
+        m_route = 1;
+
+    const Position startOrigin = getClusterOrigin(start);
+    const Position goalOrigin = getClusterOrigin(goal);
+
+    ClusterTiles tiles;
+    std::vector<float> startCosts, goalCosts;
+    g_minimap.threadGetBlockTiles(startOrigin, tiles);
+    searchCluster(tiles, getTileIndex(start), false, startCosts);
+    g_minimap.threadGetBlockTiles(goalOrigin, tiles);
+    searchCluster(tiles, getTileIndex(goal), true, goalCosts);
+
+    struct RouteNode
+    {
+        float cost;
+        Position prev;
+        bool closed;
+    };
+
+    struct LessRouteNode
+    {
+        bool operator()(const std::pair<float, Position>& a, const std::pair<float, Position>& b) const { return b.first < a.first; }
+    };
+
+    std::unordered_map<Position, RouteNode, Position::Hasher> nodes;
+    std::priority_queue<std::pair<float, Position>, std::vector<std::pair<float, Position>>, LessRouteNode> searchList;
+
+    const auto open = [&](const Position& pos, float cost, const Position& prev) {
+        RouteNode& node = nodes.try_emplace(pos, RouteNode{ NO_WAY, {}, false }).first->second;
+        if (node.closed || cost >= node.cost)
+            return;
+
+        node.cost = cost;
+        node.prev = prev;
+        searchList.emplace(cost + pos.distance(goal) * HEURISTIC_TILE_COST, pos);
+    };
+
+    nodes.emplace(start, RouteNode{ 0, {}, false });
+    searchList.emplace(0, start);
+
+    uint32_t expanded = 0;
+    bool found = false;
+    while (!searchList.empty()) {
+        const Position pos = searchList.top().second;
+        searchList.pop();
+
+        RouteNode& node = nodes[pos];
+        if (node.closed)
+            continue;
+        node.closed = true;
+
+        if (pos == goal) {
+            found = true;
+            break;
+        }
+
+        if (++expanded > MAX_ROUTE_NODES)
+            return Otc::PathFindResultTooFar;
+
+        const float cost = node.cost;
+        const Position origin = getClusterOrigin(pos);
+        const Cluster& cluster = getCluster(pos);
+
+        if (origin == goalOrigin && goalCosts[getTileIndex(pos)] != NO_WAY)
+            open(goal, cost + goalCosts[getTileIndex(pos)], pos);
+
+        if (pos == start) {
+            for (const Entrance& entrance : cluster.entrances) {
+                if (startCosts[getTileIndex(entrance.pos)] != NO_WAY)
+                    open(entrance.pos, startCosts[getTileIndex(entrance.pos)], pos);
+            }
+        }
+
+        const int index = findEntrance(cluster, pos);
+        if (index < 0)
+            continue;
+
+        const size_t count = cluster.entrances.size();
+        for (size_t i = 0; i < count; ++i) {
+            const float intraCost = cluster.costs[index * count + i];
+            if (intraCost != NO_WAY)
+                open(cluster.entrances[i].pos, cost + intraCost, pos);
+        }
+
+        for (const Exit& exit : cluster.entrances[index].exits)
+            open(exit.peer, cost + exit.cost, pos);
+    }
+
+    if (!found)
+        return Otc::PathFindResultNoWay;
+
+    for (Position pos = goal; pos != start; pos = nodes[pos].prev)
+        waypoints.push_back(pos);
+    std::reverse(waypoints.begin(), waypoints.end());
+
+    return Otc::PathFindResultOk;
+}
+
+void HierarchicalPathFinder::clear()
+{
+    std::lock_guard lock(m_mutex);
+    m_clusters.clear();
+}
+
+size_t HierarchicalPathFinder::getClusterCount()
+{
+    std::lock_guard lock(m_mutex);
+    return m_clusters.size();
+}
+
+HierarchicalPathFinder::Cluster& HierarchicalPathFinder::getCluster(const Position& pos)
+{
+    Cluster& cluster = m_clusters[getClusterKey(pos)];
+    if (cluster.checkedRoute == m_route)
+        return cluster;
+
+    cluster.checkedRoute = m_route;
+
+    const Position origin = getClusterOrigin(pos);
+    std::array<uint32_t, 5> versions{};
+    versions[0] = g_minimap.threadGetBlockVersion(origin);
+    for (int i = 0; i < 4; ++i) {
+        const Position neighbor = origin.translated(borders[i][0] * CLUSTER_SIZE, borders[i][1] * CLUSTER_SIZE);
+        if (neighbor.x >= 0 && neighbor.y >= 0)
+            versions[i + 1] = g_minimap.threadGetBlockVersion(neighbor);
+    }
+
+    // a change in a neighbor moves the entrances on the shared border
+    if (versions != cluster.versions || cluster.costs.size() != cluster.entrances.size() * cluster.entrances.size())
+        buildCluster(cluster, origin);
+
+    return cluster;
+}
+
+void HierarchicalPathFinder::buildCluster(Cluster& cluster, const Position& origin)
+{
+    cluster.entrances.clear();
+    cluster.versions.fill(0);
+
+    ClusterTiles tiles;
+    cluster.versions[0] = g_minimap.threadGetBlockTiles(origin, tiles);
+
+    ClusterTiles neighborTiles;
+    for (int i = 0; i < 4; ++i) {
+        const int dx = borders[i][0], dy = borders[i][1];
+        const Position neighborOrigin = origin.translated(dx * CLUSTER_SIZE, dy * CLUSTER_SIZE);
+        if (neighborOrigin.x < 0 || neighborOrigin.y < 0)
+            continue;
+
+        cluster.versions[i + 1] = g_minimap.threadGetBlockTiles(neighborOrigin, neighborTiles);
+
+        // tiles on both sides of the border, walked in the same order from either cluster
+        const auto borderTile = [&](int t) { return dx != 0 ? origin.translated(dx > 0 ? CLUSTER_SIZE - 1 : 0, t) : origin.translated(t, dy > 0 ? CLUSTER_SIZE - 1 : 0); };
+        const auto isOpen = [&](int t) {
+            const Position pos = borderTile(t);
+            return isWalkable(tiles[getTileIndex(pos)]) && isWalkable(neighborTiles[getTileIndex(pos.translated(dx, dy))]);
+        };
+
+        // every walkable run across the border gets an entrance in its middle, long runs one per part
+        for (int t = 0; t < CLUSTER_SIZE;) {
+            if (!isOpen(t)) {
+                ++t;
+                continue;
+            }
+
+            int end = t + 1;
+            while (end < CLUSTER_SIZE && end - t < MAX_ENTRANCE_WIDTH && isOpen(end))
+                ++end;
+
+            const Position pos = borderTile((t + end - 1) / 2);
+            const Position peer = pos.translated(dx, dy);
+
+            int index = findEntrance(cluster, pos);
+            if (index < 0) {
+                index = cluster.entrances.size();
+                cluster.entrances.push_back({ pos, {} });
+            }
+            cluster.entrances[index].exits.push_back({ peer, static_cast<float>(neighborTiles[getTileIndex(peer)].getSpeed()) });
+
+            t = end;
+        }
+    }
+
+    const size_t count = cluster.entrances.size();
+    cluster.costs.assign(count * count, NO_WAY);
+
+    std::vector<float> costs;
+    for (size_t i = 0; i < count; ++i) {
+        searchCluster(tiles, getTileIndex(cluster.entrances[i].pos), false, costs);
+        for (size_t j = 0; j < count; ++j) {
+            if (i != j)
+                cluster.costs[i * count + j] = costs[getTileIndex(cluster.entrances[j].pos)];
+        }
+    }
+}
+
+int HierarchicalPathFinder::findEntrance(const Cluster& cluster, const Position& pos) const
+{
+    for (size_t i = 0; i < cluster.entrances.size(); ++i) {
+        if (cluster.entrances[i].pos == pos)
+            return i;
+    }
+    return -1;
+}
+
+// dijkstra inside a single cluster, reverse gives the cost from every tile to the source instead
+void HierarchicalPathFinder::searchCluster(const ClusterTiles& tiles, int from, bool reverse, std::vector<float>& costs)
+{
+    costs.assign(tiles.size(), NO_WAY);
+    costs[from] = 0;
+
+    std::priority_queue<std::pair<float, int>, std::vector<std::pair<float, int>>, std::greater<>> searchList;
+    searchList.emplace(0, from);
+
+    while (!searchList.empty()) {
+        const auto [cost, index] = searchList.top();
+        searchList.pop();
+        if (cost > costs[index])
+            continue;
+
+        const int x = index % CLUSTER_SIZE, y = index / CLUSTER_SIZE;
+        for (int i = -1; i <= 1; ++i) {
+            for (int j = -1; j <= 1; ++j) {
+                if ((i == 0 && j == 0) || x + i < 0 || x + i >= CLUSTER_SIZE || y + j < 0 || y + j >= CLUSTER_SIZE)
+                    continue;
+
+                const int neighbor = (y + j) * CLUSTER_SIZE + x + i;
+                if (!isWalkable(tiles[neighbor]))
+                    continue;
+
+                // stepping onto a tile costs its speed, three times over for diagonals
+                const float walkFactor = i == 0 || j == 0 ? 1.0f : 3.0f;
+                const float neighborCost = cost + tiles[reverse ? index : neighbor].getSpeed() * walkFactor;
+                if (neighborCost < costs[neighbor]) {
+                    costs[neighbor] = neighborCost;
+                    searchList.emplace(neighborCost, neighbor);
+                }
+            }
+        }
+    }
+}
+
+uint64_t HierarchicalPathFinder::getClusterKey(const Position& pos)
+{
+    return static_cast<uint64_t>(pos.z) << 32 | static_cast<uint32_t>(pos.y / CLUSTER_SIZE) << 16 | static_cast<uint32_t>(pos.x / CLUSTER_SIZE);
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "declarations.h"
+#include "minimap.h"
+#include "position.h"
+
+#include <unordered_map>
+
+// long distance routes over the minimap: every floor is split in clusters matching the
+// minimap blocks, walkable runs across cluster borders become entrances and the costs between
+// the entrances of a cluster are precomputed, so a route is searched entrance to entrance and
+// only the leg ahead of the player has to be searched tile by tile
+class HierarchicalPathFinder
+{
+public:
+    // entrances from start to goal, ending with goal itself
+    Otc::PathFindResult findRoute(const Position& start, const Position& goal, std::vector<Position>& waypoints);
+
+    void clear();
+    size_t getClusterCount();
+
+private:
+    static constexpr int CLUSTER_SIZE = MMBLOCK_SIZE;
+    static constexpr float NO_WAY = std::numeric_limits<float>::infinity();
+    static constexpr float HEURISTIC_TILE_COST = 100.f;
+
+    enum
+    {
+        MAX_ENTRANCE_WIDTH = 16,
+        MAX_ROUTE_NODES = 200000
+    };
+
+    using ClusterTiles = std::array<MinimapTile, CLUSTER_SIZE* CLUSTER_SIZE>;
+
+    struct Exit
+    {
+        Position peer; // entrance on the other side of the border
+        float cost;
+    };
+
+    struct Entrance
+    {
+        Position pos;
+        std::vector<Exit> exits;
+    };
+
+    struct Cluster
+    {
+        // walk versions of the block and its four neighbors the cluster was built from
+        std::array<uint32_t, 5> versions{};
+        std::vector<Entrance> entrances;
+        std::vector<float> costs; // entrances x entrances
+        uint32_t checkedRoute{ 0 };
+    };
+
+    Cluster& getCluster(const Position& pos);
+    void buildCluster(Cluster& cluster, const Position& origin);
+    int findEntrance(const Cluster& cluster, const Position& pos) const;
+    static void searchCluster(const ClusterTiles& tiles, int from, bool reverse, std::vector<float>& costs);
+
+    static uint64_t getClusterKey(const Position& pos);
+    static Position getClusterOrigin(const Position& pos) { return { pos.x - pos.x % CLUSTER_SIZE, pos.y - pos.y % CLUSTER_SIZE, pos.z }; }
+    static int getTileIndex(const Position& pos) { return (pos.y % CLUSTER_SIZE) * CLUSTER_SIZE + pos.x % CLUSTER_SIZE; }
+
+    // entrances point into neighbor clusters, so clusters must not move when others are added
+    std::unordered_map<uint64_t, Cluster> m_clusters;
+    uint32_t m_route{ 0 };
+    std::mutex m_mutex;
+};
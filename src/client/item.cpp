@@ -83,11 +83,16 @@ void Item::setId(uint32_t id)
     if (!g_things.isValidDatId(id, ThingCategoryItem))
         id = 0;
 
+    const bool indexed = isOnMap();
+    if (indexed) g_map.unindexItem(static_self_cast<Item>(), m_position);
+
     m_serverId = g_things.findItemTypeByClientId(id)->getServerId();
     m_clientId = id;
     m_thingType = nullptr;
     generateBuffer();
 
+    if (indexed) g_map.indexItem(static_self_cast<Item>(), m_position);
+
     // Shader example on only items that can be marketed.
     /*
     if (isMarketable()) {
@@ -114,9 +119,23 @@ void Item::setOtbId(uint16_t id)
     if (!g_things.isValidDatId(id, ThingCategoryItem))
         id = 0;
 
+    const bool indexed = isOnMap();
+    if (indexed) g_map.unindexItem(static_self_cast<Item>(), m_position);
+
     m_clientId = id;
     m_thingType = nullptr;
     generateBuffer();
+
+    if (indexed) g_map.indexItem(static_self_cast<Item>(), m_position);
+}
+
+bool Item::isOnMap()
+{
+    if (!g_map.isItemIndexEnabled())
+        return false;
+
+    const TilePtr& tile = getTile();
+    return tile && tile->hasThing(static_self_cast<Item>());
 }
 
 void Item::setPosition(const Position& position, uint8_t stackPos, bool hasElevation)
@@ -418,4 +437,9 @@ const ThingTypePtr& Item::getThingType()
 {
     return m_thingType ? m_thingType : m_thingType = g_things.getThingType(m_clientId, ThingCategoryItem);
 }
+
+uint64_t Item::getThingFlags()
+{
+    return g_things.getThingFlags(m_clientId, ThingCategoryItem);
+}
 /* vim: set ts=4 sw=4 et :*/
@@ -145,10 +145,14 @@ public:
     int getExactSize(int layer = 0, int xPattern = 0, int yPattern = 0, int zPattern = 0, int animationPhase = 0) override;
 
     const ThingTypePtr& getThingType() override;
+    uint64_t getThingFlags() override;
 
     void onPositionChange(const Position& /*newPos*/, const Position& /*oldPos*/) override { updatePatterns(); }
 
 private:
+    // whether the item lies on a map tile and so is in the map's item index
+    bool isOnMap();
+
     uint16_t m_clientId{ 0 },
         m_serverId{ 0 };
 
@@ -150,8 +150,12 @@ bool LocalPlayer::autoWalk(const Position& destination, const bool retry)
     std::vector<Otc::Direction> limitedPath;
 
     m_autoWalkDestination = destination;
+    // a new destination supersedes the search still running for the previous one
+    if (m_autoWalkRequest)
+        m_autoWalkRequest->cancel();
+
     auto self(asLocalPlayer());
-    g_map.findPathAsync(m_position, destination, [self](const PathFindResult_ptr& result) {
+    m_autoWalkRequest = g_map.findPathAsync(m_position, destination, [self](const PathFindResult_ptr& result) {
         if (self->m_autoWalkDestination != result->destination)
             return;
 
@@ -198,6 +202,11 @@ void LocalPlayer::stopAutoWalk()
     m_lastAutoWalkPosition = {};
     m_knownCompletePath = false;
 
+    if (m_autoWalkRequest) {
+        m_autoWalkRequest->cancel();
+        m_autoWalkRequest = nullptr;
+    }
+
     if (m_autoWalkContinueEvent)
         m_autoWalkContinueEvent->cancel();
 }
@@ -135,6 +135,7 @@ private:
         m_autoWalkDestination;
 
     ScheduledEventPtr m_autoWalkContinueEvent;
+    PathFindRequestPtr m_autoWalkRequest;
     ticks_t m_walkLockExpiration{ 0 };
 
     bool m_preWalking{ false },
@@ -33,6 +33,7 @@
 #include "map.h"
 #include "minimap.h"
 #include "missile.h"
+#include "opcodestats.h"
 #include "outfit.h"
 #include "player.h"
 #include "protocolgame.h"
@@ -75,6 +76,14 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_things", "findItemTypesByString", &ThingTypeManager::findItemTypesByString, &g_things);
     g_lua.bindSingletonFunction("g_things", "findItemTypeByCategory", &ThingTypeManager::findItemTypeByCategory, &g_things);
     g_lua.bindSingletonFunction("g_things", "findThingTypeByAttr", &ThingTypeManager::findThingTypeByAttr, &g_things);
+    g_lua.bindSingletonFunction("g_things", "setTextureAtlasEnabled", &ThingTypeManager::setTextureAtlasEnabled, &g_things);
+    g_lua.bindSingletonFunction("g_things", "isTextureAtlasEnabled", &ThingTypeManager::isTextureAtlasEnabled, &g_things);
+    g_lua.bindSingletonFunction("g_things", "getTextureAtlasStats", &ThingTypeManager::getTextureAtlasStats, &g_things);
+    g_lua.bindSingletonFunction("g_things", "resetTextureAtlasStats", &ThingTypeManager::resetTextureAtlasStats, &g_things);
+    g_lua.bindSingletonFunction("g_things", "setTextureComposerEnabled", &ThingTypeManager::setTextureComposerEnabled, &g_things);
+    g_lua.bindSingletonFunction("g_things", "isTextureComposerEnabled", &ThingTypeManager::isTextureComposerEnabled, &g_things);
+    g_lua.bindSingletonFunction("g_things", "getTextureComposerStats", &ThingTypeManager::getTextureComposerStats, &g_things);
+    g_lua.bindSingletonFunction("g_things", "resetTextureComposerStats", &ThingTypeManager::resetTextureComposerStats, &g_things);
 
     g_lua.registerSingletonClass("g_houses");
     g_lua.bindSingletonFunction("g_houses", "clear", &HouseManager::clear, &g_houses);
@@ -96,6 +105,16 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_towns", "getTowns", &TownManager::getTowns, &g_towns);
     g_lua.bindSingletonFunction("g_towns", "sort", &TownManager::sort, &g_towns);
 
+    g_lua.registerSingletonClass("g_opcodeStats");
+    g_lua.bindSingletonFunction("g_opcodeStats", "reset", &OpcodeStats::reset, &g_opcodeStats);
+    g_lua.bindSingletonFunction("g_opcodeStats", "setEnabled", &OpcodeStats::setEnabled, &g_opcodeStats);
+    g_lua.bindSingletonFunction("g_opcodeStats", "isEnabled", &OpcodeStats::isEnabled, &g_opcodeStats);
+    g_lua.bindSingletonFunction("g_opcodeStats", "setSlowThreshold", &OpcodeStats::setSlowThreshold, &g_opcodeStats);
+    g_lua.bindSingletonFunction("g_opcodeStats", "getSlowThreshold", &OpcodeStats::getSlowThreshold, &g_opcodeStats);
+    g_lua.bindSingletonFunction("g_opcodeStats", "getStats", &OpcodeStats::getStats, &g_opcodeStats);
+    g_lua.bindSingletonFunction("g_opcodeStats", "getRecordedOpcodes", &OpcodeStats::getRecordedOpcodes, &g_opcodeStats);
+    g_lua.bindSingletonFunction("g_opcodeStats", "dump", &OpcodeStats::dump, &g_opcodeStats);
+
     g_lua.registerSingletonClass("g_sprites");
     g_lua.bindSingletonFunction("g_sprites", "loadSpr", &SpriteManager::loadSpr, &g_sprites);
     g_lua.bindSingletonFunction("g_sprites", "saveSpr", &SpriteManager::saveSpr, &g_sprites);
@@ -107,6 +126,15 @@ void Client::registerLuaFunctions()
     g_lua.registerSingletonClass("g_spriteAppearances");
     g_lua.bindSingletonFunction("g_spriteAppearances", "saveSpriteToFile", &SpriteAppearances::saveSpriteToFile, &g_spriteAppearances);
     g_lua.bindSingletonFunction("g_spriteAppearances", "saveSheetToFileBySprite", &SpriteAppearances::saveSheetToFileBySprite, &g_spriteAppearances);
+    g_lua.bindSingletonFunction("g_spriteAppearances", "setSheetCacheSize", &SpriteAppearances::setSheetCacheSize, &g_spriteAppearances);
+    g_lua.bindSingletonFunction("g_spriteAppearances", "getSheetCacheSize", &SpriteAppearances::getSheetCacheSize, &g_spriteAppearances);
+    g_lua.bindSingletonFunction("g_spriteAppearances", "getSheetCacheUsage", &SpriteAppearances::getSheetCacheUsage, &g_spriteAppearances);
+    g_lua.bindSingletonFunction("g_spriteAppearances", "getSheetCacheStats", &SpriteAppearances::getSheetCacheStats, &g_spriteAppearances);
+    g_lua.bindSingletonFunction("g_spriteAppearances", "resetSheetCacheStats", &SpriteAppearances::resetSheetCacheStats, &g_spriteAppearances);
+    g_lua.bindSingletonFunction("g_spriteAppearances", "benchmarkSheetLookup", &SpriteAppearances::benchmarkSheetLookup, &g_spriteAppearances);
+    g_lua.bindSingletonFunction("g_spriteAppearances", "setSheetDiskCacheEnabled", &SpriteAppearances::setSheetDiskCacheEnabled, &g_spriteAppearances);
+    g_lua.bindSingletonFunction("g_spriteAppearances", "isSheetDiskCacheEnabled", &SpriteAppearances::isSheetDiskCacheEnabled, &g_spriteAppearances);
+    g_lua.bindSingletonFunction("g_spriteAppearances", "clearSheetDiskCache", &SpriteAppearances::clearSheetDiskCache, &g_spriteAppearances);
 
     g_lua.registerSingletonClass("g_map");
     g_lua.bindSingletonFunction("g_map", "isLookPossible", &Map::isLookPossible, &g_map);
@@ -123,12 +151,26 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_map", "cleanTexts", &Map::cleanTexts, &g_map);
     g_lua.bindSingletonFunction("g_map", "getTile", &Map::getTile, &g_map);
     g_lua.bindSingletonFunction("g_map", "getTiles", &Map::getTiles, &g_map);
+    g_lua.bindSingletonFunction("g_map", "setTileGridEnabled", &Map::setTileGridEnabled, &g_map);
+    g_lua.bindSingletonFunction("g_map", "isTileGridEnabled", &Map::isTileGridEnabled, &g_map);
+    g_lua.bindSingletonFunction("g_map", "benchmarkTileLookup", &Map::benchmarkTileLookup, &g_map);
+    g_lua.bindSingletonFunction("g_map", "benchmarkTileAnalysis", &Map::benchmarkTileAnalysis, &g_map);
     g_lua.bindSingletonFunction("g_map", "setCentralPosition", &Map::setCentralPosition, &g_map);
     g_lua.bindSingletonFunction("g_map", "getCentralPosition", &Map::getCentralPosition, &g_map);
     g_lua.bindSingletonFunction("g_map", "getCreatureById", &Map::getCreatureById, &g_map);
     g_lua.bindSingletonFunction("g_map", "removeCreatureById", &Map::removeCreatureById, &g_map);
     g_lua.bindSingletonFunction("g_map", "getSpectators", &Map::getSpectators, &g_map);
+    g_lua.bindSingletonFunction("g_map", "setSpectatorCacheEnabled", &Map::setSpectatorCacheEnabled, &g_map);
+    g_lua.bindSingletonFunction("g_map", "isSpectatorCacheEnabled", &Map::isSpectatorCacheEnabled, &g_map);
     g_lua.bindSingletonFunction("g_map", "findPath", &Map::findPath, &g_map);
+    g_lua.bindSingletonFunction("g_map", "benchmarkFindPath", &Map::benchmarkFindPath, &g_map);
+    g_lua.bindSingletonFunction("g_map", "getPathFindStats", &Map::getPathFindStats, &g_map);
+    g_lua.bindSingletonFunction("g_map", "resetPathFindStats", &Map::resetPathFindStats, &g_map);
+    g_lua.bindSingletonFunction("g_map", "setPathCacheEnabled", &Map::setPathCacheEnabled, &g_map);
+    g_lua.bindSingletonFunction("g_map", "isPathCacheEnabled", &Map::isPathCacheEnabled, &g_map);
+    g_lua.bindSingletonFunction("g_map", "clearPathCache", &Map::clearPathCache, &g_map);
+    g_lua.bindSingletonFunction("g_map", "getPathCacheStats", &Map::getPathCacheStats, &g_map);
+    g_lua.bindSingletonFunction("g_map", "resetPathCacheStats", &Map::resetPathCacheStats, &g_map);
     g_lua.bindSingletonFunction("g_map", "loadOtbm", &Map::loadOtbm, &g_map);
     g_lua.bindSingletonFunction("g_map", "saveOtbm", &Map::saveOtbm, &g_map);
     g_lua.bindSingletonFunction("g_map", "loadOtcm", &Map::loadOtcm, &g_map);
@@ -159,6 +201,11 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_map", "beginGhostMode", &Map::beginGhostMode, &g_map);
     g_lua.bindSingletonFunction("g_map", "endGhostMode", &Map::endGhostMode, &g_map);
     g_lua.bindSingletonFunction("g_map", "findItemsById", &Map::findItemsById, &g_map);
+    g_lua.bindSingletonFunction("g_map", "findItemsByIdRange", &Map::findItemsByIdRange, &g_map);
+    g_lua.bindSingletonFunction("g_map", "findItemsByAttr", &Map::findItemsByAttr, &g_map);
+    g_lua.bindSingletonFunction("g_map", "findItemsByCategory", &Map::findItemsByCategory, &g_map);
+    g_lua.bindSingletonFunction("g_map", "setItemIndexEnabled", &Map::setItemIndexEnabled, &g_map);
+    g_lua.bindSingletonFunction("g_map", "isItemIndexEnabled", &Map::isItemIndexEnabled, &g_map);
     g_lua.bindSingletonFunction("g_map", "setFloatingEffect", &Map::setFloatingEffect, &g_map);
     g_lua.bindSingletonFunction("g_map", "isDrawingFloatingEffects", &Map::isDrawingFloatingEffects, &g_map);
 
@@ -190,6 +237,15 @@ void Client::registerLuaFunctions()
 
     g_lua.registerSingletonClass("g_game");
     g_lua.bindSingletonFunction("g_game", "loginWorld", &Game::loginWorld, &g_game);
+    g_lua.bindSingletonFunction("g_game", "startRecording", &Game::startRecording, &g_game);
+    g_lua.bindSingletonFunction("g_game", "stopRecording", &Game::stopRecording, &g_game);
+    g_lua.bindSingletonFunction("g_game", "isRecording", &Game::isRecording, &g_game);
+    g_lua.bindSingletonFunction("g_game", "playRecording", &Game::playRecording, &g_game);
+    g_lua.bindSingletonFunction("g_game", "stopPlayback", &Game::stopPlayback, &g_game);
+    g_lua.bindSingletonFunction("g_game", "isPlayingBack", &Game::isPlayingBack, &g_game);
+    g_lua.bindSingletonFunction("g_game", "benchmarkRecording", &Game::benchmarkRecording, &g_game);
+    g_lua.bindSingletonFunction("g_game", "getXteaKernel", &Game::getXteaKernel, &g_game);
+    g_lua.bindSingletonFunction("g_game", "benchmarkXtea", &Game::benchmarkXtea, &g_game);
     g_lua.bindSingletonFunction("g_game", "cancelLogin", &Game::cancelLogin, &g_game);
     g_lua.bindSingletonFunction("g_game", "forceLogout", &Game::forceLogout, &g_game);
     g_lua.bindSingletonFunction("g_game", "safeLogout", &Game::safeLogout, &g_game);
@@ -353,6 +409,8 @@ void Client::registerLuaFunctions()
 
     g_lua.registerClass<ProtocolGame, Protocol>();
     g_lua.bindClassStaticFunction<ProtocolGame>("create", [] { return ProtocolGamePtr(new ProtocolGame); });
+    g_lua.bindClassStaticFunction<ProtocolGame>("setOpcodeHooked", &ProtocolGame::setOpcodeHooked);
+    g_lua.bindClassStaticFunction<ProtocolGame>("isOpcodeHooked", &ProtocolGame::isOpcodeHooked);
     g_lua.bindClassMemberFunction<ProtocolGame>("login", &ProtocolGame::login);
     g_lua.bindClassMemberFunction<ProtocolGame>("sendExtendedOpcode", &ProtocolGame::sendExtendedOpcode);
     g_lua.bindClassMemberFunction<ProtocolGame>("addPosition", &ProtocolGame::addPosition);
@@ -364,6 +422,16 @@ void Client::registerLuaFunctions()
     g_lua.bindClassMemberFunction<ProtocolGame>("getCreature", &ProtocolGame::getCreature);
     g_lua.bindClassMemberFunction<ProtocolGame>("getItem", &ProtocolGame::getItem);
     g_lua.bindClassMemberFunction<ProtocolGame>("getPosition", &ProtocolGame::getPosition);
+    g_lua.bindClassMemberFunction<ProtocolGame>("setHeadless", &ProtocolGame::setHeadless);
+    g_lua.bindClassMemberFunction<ProtocolGame>("isHeadless", &ProtocolGame::isHeadless);
+    g_lua.bindClassMemberFunction<ProtocolGame>("sendLogout", &ProtocolGame::sendLogout);
+    g_lua.bindClassMemberFunction<ProtocolGame>("sendPing", &ProtocolGame::sendPing);
+    g_lua.bindClassMemberFunction<ProtocolGame>("sendWalkNorth", &ProtocolGame::sendWalkNorth);
+    g_lua.bindClassMemberFunction<ProtocolGame>("sendWalkEast", &ProtocolGame::sendWalkEast);
+    g_lua.bindClassMemberFunction<ProtocolGame>("sendWalkSouth", &ProtocolGame::sendWalkSouth);
+    g_lua.bindClassMemberFunction<ProtocolGame>("sendWalkWest", &ProtocolGame::sendWalkWest);
+    g_lua.bindClassMemberFunction<ProtocolGame>("sendTalk", &ProtocolGame::sendTalk);
+    g_lua.bindClassMemberFunction<ProtocolGame>("sendAttack", &ProtocolGame::sendAttack);
 
     g_lua.registerClass<Container>();
     g_lua.bindClassMemberFunction<Container>("getItem", &Container::getItem);
@@ -787,6 +855,7 @@ void Client::registerLuaFunctions()
     g_lua.bindClassMemberFunction<UIMap>("setDrawLights", &UIMap::setDrawLights);
     g_lua.bindClassMemberFunction<UIMap>("setLimitVisibleDimension", &UIMap::setLimitVisibleDimension);
     g_lua.bindClassMemberFunction<UIMap>("setDrawManaBar", &UIMap::setDrawManaBar);
+    g_lua.bindClassMemberFunction<UIMap>("setIncrementalVisibleTiles", &UIMap::setIncrementalVisibleTiles);
     g_lua.bindClassMemberFunction<UIMap>("setKeepAspectRatio", &UIMap::setKeepAspectRatio);
     g_lua.bindClassMemberFunction<UIMap>("setMapShader", &UIMap::setMapShader);
     g_lua.bindClassMemberFunction<UIMap>("setMinimumAmbientLight", &UIMap::setMinimumAmbientLight);
@@ -798,6 +867,7 @@ void Client::registerLuaFunctions()
     g_lua.bindClassMemberFunction<UIMap>("isDrawingLights", &UIMap::isDrawingLights);
     g_lua.bindClassMemberFunction<UIMap>("isLimitedVisibleDimension", &UIMap::isLimitedVisibleDimension);
     g_lua.bindClassMemberFunction<UIMap>("isDrawingManaBar", &UIMap::isDrawingManaBar);
+    g_lua.bindClassMemberFunction<UIMap>("isIncrementalVisibleTiles", &UIMap::isIncrementalVisibleTiles);
     g_lua.bindClassMemberFunction<UIMap>("isLimitVisibleRangeEnabled", &UIMap::isLimitVisibleRangeEnabled);
     g_lua.bindClassMemberFunction<UIMap>("isKeepAspectRatioEnabled", &UIMap::isKeepAspectRatioEnabled);
     g_lua.bindClassMemberFunction<UIMap>("isInRange", &UIMap::isInRange);
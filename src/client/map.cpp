@@ -28,6 +28,7 @@
 #include "minimap.h"
 #include "missile.h"
 #include "statictext.h"
+#include "thingtypemanager.h"
 #include "tile.h"
 
 #include <framework/core/asyncdispatcher.h>
@@ -46,10 +47,12 @@ void Map::init()
 {
     resetAwareRange();
     m_animationFlags |= Animation_Show;
+    m_pathFindService.init();
 }
 
 void Map::terminate()
 {
+    m_pathFindService.terminate();
     clean();
 }
 
@@ -93,6 +96,9 @@ void Map::notificateTileUpdate(const Position& pos, const ThingPtr& thing, const
         mapView->onTileUpdate(pos, thing, operation);
     }
 
+    if (!thing || thing->isItem() || thing->isCreature())
+        updateMapVersion(pos);
+
     g_minimap.updateTile(pos, getTile(pos));
 }
 
@@ -100,10 +106,21 @@ void Map::clean()
 {
     cleanDynamicThings();
 
-    for (int_fast8_t i = -1; ++i <= MAX_Z;)
+    for (int_fast8_t i = -1; ++i <= MAX_Z;) {
         m_tileBlocks[i].clear();
+        m_creatureCells[i].clear();
+        m_regionVersions[i].clear();
+        m_floorVersions[i] = ++m_mapVersion;
+    }
+    m_itemIndex.clear();
+    m_spectatorCache.clear();
+
+    for (auto& grid : m_tileGrids)
+        grid.clear();
 
     m_waypoints.clear();
+    m_hierarchicalPathFinder.clear();
+    m_pathCache.clear();
 
     g_towns.clear();
     g_houses.clear();
@@ -306,7 +323,12 @@ const TilePtr& Map::createTile(const Position& pos)
         return m_nulltile;
 
     TileBlock& block = m_tileBlocks[pos.z][getBlockIndex(pos)];
-    return block.create(pos);
+    if (const TilePtr& oldTile = block.get(pos))
+        unindexTile(oldTile);
+
+    const TilePtr& tile = block.create(pos);
+    setGridTile(pos, tile);
+    return tile;
 }
 
 template <typename... Items>
@@ -329,7 +351,9 @@ const TilePtr& Map::getOrCreateTile(const Position& pos)
         return m_nulltile;
 
     TileBlock& block = m_tileBlocks[pos.z][getBlockIndex(pos)];
-    return block.getOrCreate(pos);
+    const TilePtr& tile = block.getOrCreate(pos);
+    setGridTile(pos, tile);
+    return tile;
 }
 
 const TilePtr& Map::getTile(const Position& pos)
@@ -337,6 +361,17 @@ const TilePtr& Map::getTile(const Position& pos)
     if (!pos.isMapPosition())
         return m_nulltile;
 
+    if (m_tileGridEnabled) {
+        TileGrid& grid = m_tileGrids[pos.z];
+        if (grid.contains(pos))
+            return grid.at(pos);
+    }
+
+    return getBlockTile(pos);
+}
+
+const TilePtr& Map::getBlockTile(const Position& pos)
+{
     auto& tileBlocks = m_tileBlocks[pos.z];
 
     const auto it = tileBlocks.find(getBlockIndex(pos));
@@ -386,12 +421,15 @@ void Map::cleanTile(const Position& pos)
         TileBlock& block = it->second;
         if (const TilePtr& tile = block.get(pos)) {
             tile->clean();
-            if (tile->canErase())
+            if (tile->canErase()) {
                 block.remove(pos);
+                setGridTile(pos, nullptr);
+            }
 
             notificateTileUpdate(pos, nullptr, Otc::OPERATION_CLEAN);
         } else {
             g_minimap.updateTile(pos, nullptr);
+            updateMapVersion(pos);
         }
     }
 
@@ -458,10 +496,57 @@ void Map::setShowAnimations(bool show)
 void Map::beginGhostMode(float opacity) { g_painter->setOpacity(opacity); }
 void Map::endGhostMode() { g_painter->resetOpacity(); }
 
-std::map<Position, ItemPtr> Map::findItemsById(uint16_t clientId, uint32_t  max)
+std::map<Position, ItemPtr> Map::findItemsById(uint16_t clientId, uint32_t max)
 {
     std::map<Position, ItemPtr> ret;
-    uint32_t  count = 0;
+    for (const ItemPtr& item : findItems([clientId](uint16_t id) { return id == clientId; }, max))
+        ret.emplace(item->getPosition(), item);
+
+    return ret;
+}
+
+std::vector<ItemPtr> Map::findItemsByIdRange(uint16_t firstClientId, uint16_t lastClientId, uint32_t max)
+{
+    return findItems([=](uint16_t id) { return id >= firstClientId && id <= lastClientId; }, max);
+}
+
+std::vector<ItemPtr> Map::findItemsByAttr(ThingAttr attr, uint32_t max)
+{
+    // the flag word only holds the attributes below ThingFlagNotPreWalkable, others come from the type
+    if (attr == ThingAttrNotPreWalkable)
+        return findItems([](uint16_t id) { return hasThingFlag(g_things.getThingFlags(id, ThingCategoryItem), ThingFlagNotPreWalkable); }, max);
+
+    if (attr >= ThingFlagNotPreWalkable)
+        return findItems([attr](uint16_t id) { return g_things.getThingType(id, ThingCategoryItem)->hasAttr(attr); }, max);
+
+    return findItems([attr](uint16_t id) { return hasThingFlag(g_things.getThingFlags(id, ThingCategoryItem), attr); }, max);
+}
+
+std::vector<ItemPtr> Map::findItemsByCategory(ItemCategory category, uint32_t max)
+{
+    return findItems([category](uint16_t id) { return g_things.findItemTypeByClientId(id)->getCategory() == category; }, max);
+}
+
+std::vector<ItemPtr> Map::findItems(const std::function<bool(uint16_t)>& filter, uint32_t max)
+{
+    std::vector<ItemPtr> ret;
+    if (max == 0)
+        return ret;
+
+    if (m_itemIndexEnabled) {
+        for (const auto& [clientId, items] : m_itemIndex) {
+            if (!filter(clientId))
+                continue;
+
+            for (const auto& [pos, item] : items) {
+                ret.push_back(item);
+                if (ret.size() >= max)
+                    return ret;
+            }
+        }
+        return ret;
+    }
+
     for (uint8_t z = 0; z <= MAX_Z; ++z) {
         for (const auto& pair : m_tileBlocks[z]) {
             const TileBlock& block = pair.second;
@@ -469,10 +554,10 @@ std::map<Position, ItemPtr> Map::findItemsById(uint16_t clientId, uint32_t  max)
                 if (unlikely(!tile || tile->isEmpty()))
                     continue;
                 for (const ItemPtr& item : tile->getItems()) {
-                    if (item->getId() == clientId) {
-                        ret.emplace(tile->getPosition(), item);
-                        if (++count >= max)
-                            break;
+                    if (filter(item->getClientId())) {
+                        ret.push_back(item);
+                        if (ret.size() >= max)
+                            return ret;
                     }
                 }
             }
@@ -482,6 +567,68 @@ std::map<Position, ItemPtr> Map::findItemsById(uint16_t clientId, uint32_t  max)
     return ret;
 }
 
+void Map::setItemIndexEnabled(bool enable)
+{
+    if (m_itemIndexEnabled == enable)
+        return;
+
+    m_itemIndexEnabled = enable;
+    m_itemIndex.clear();
+    if (!enable)
+        return;
+
+    for (uint8_t z = 0; z <= MAX_Z; ++z) {
+        for (const auto& pair : m_tileBlocks[z]) {
+            for (const TilePtr& tile : pair.second.getTiles()) {
+                if (!tile || tile->isEmpty())
+                    continue;
+                for (const ItemPtr& item : tile->getItems())
+                    indexItem(item, tile->getPosition());
+            }
+        }
+    }
+}
+
+void Map::indexItem(const ItemPtr& item, const Position& pos)
+{
+    if (m_itemIndexEnabled)
+        m_itemIndex[item->getClientId()].emplace_back(pos, item);
+}
+
+void Map::unindexItem(const ItemPtr& item, const Position& pos)
+{
+    if (!m_itemIndexEnabled)
+        return;
+
+    const auto it = m_itemIndex.find(item->getClientId());
+    if (it == m_itemIndex.end())
+        return;
+
+    auto& items = it->second;
+    const auto entry = std::find_if(items.begin(), items.end(), [&](const auto& e) { return e.second == item && e.first == pos; });
+    if (entry != items.end()) {
+        *entry = std::move(items.back());
+        items.pop_back();
+    }
+
+    if (items.empty())
+        m_itemIndex.erase(it);
+}
+
+void Map::unindexTile(const TilePtr& tile)
+{
+    const Position& pos = tile->getPosition();
+    if (tile->hasCreature()) {
+        for (const CreaturePtr& creature : tile->getCreatures())
+            unindexCreature(creature, pos);
+    }
+
+    if (m_itemIndexEnabled) {
+        for (const ItemPtr& item : tile->getItems())
+            unindexItem(item, pos);
+    }
+}
+
 void Map::addCreature(const CreaturePtr& creature)
 {
     m_knownCreatures[creature->getId()] = creature;
@@ -539,7 +686,9 @@ void Map::removeUnawareThings()
                         continue;
                     }
 
+                    unindexTile(tile);
                     block.remove(pos);
+                    setGridTile(pos, nullptr);
                 }
 
                 if (blockEmpty)
@@ -559,6 +708,8 @@ void Map::setCentralPosition(const Position& centralPosition)
     m_centralPosition = centralPosition;
 
     removeUnawareThings();
+    updateTileGrids();
+    m_spectatorCache.clear();
 
     // this fixes local player position when the local player is removed from the map,
     // the local player is removed from the map when there are too many creatures on his tile,
@@ -610,30 +761,107 @@ std::vector<CreaturePtr> Map::getSpectatorsInRange(const Position& centerPos, bo
 
 std::vector<CreaturePtr> Map::getSpectatorsInRangeEx(const Position& centerPos, bool multiFloor, int32_t minXRange, int32_t maxXRange, int32_t minYRange, int32_t maxYRange)
 {
-    std::vector<CreaturePtr> creatures;
-    uint8_t minZRange = 0, maxZRange = 0;
+    if (m_spectatorCacheEnabled) {
+        for (const SpectatorQuery& query : m_spectatorCache) {
+            if (query.centerPos == centerPos && query.multiFloor == multiFloor &&
+                query.minXRange == minXRange && query.maxXRange == maxXRange &&
+                query.minYRange == minYRange && query.maxYRange == maxYRange)
+                return query.creatures;
+        }
+    }
 
+    int32_t minZ = centerPos.z, maxZ = centerPos.z;
     if (multiFloor) {
-        minZRange = centerPos.z - getFirstAwareFloor();
-        maxZRange = getLastAwareFloor() - centerPos.z;
+        minZ = std::min<int32_t>(minZ, getFirstAwareFloor());
+        maxZ = std::max<int32_t>(maxZ, getLastAwareFloor());
     }
 
-    //TODO: optimize
-    //TODO: delivery creatures in distance order
-    for (int_fast8_t iz = -minZRange; iz <= maxZRange; ++iz) {
-        for (int_fast32_t iy = -minYRange; iy <= maxYRange; ++iy) {
-            for (int_fast32_t ix = -minXRange; ix <= maxXRange; ++ix) {
-                if (const TilePtr& tile = getTile(centerPos.translated(ix, iy, iz))) {
-                    auto tileCreatures = tile->getCreatures();
-                    creatures.insert(creatures.end(), tileCreatures.rbegin(), tileCreatures.rend());
+    const int32_t minX = std::max<int32_t>(centerPos.x - minXRange, 0), maxX = std::min<int32_t>(centerPos.x + maxXRange, UINT16_MAX - 1);
+    const int32_t minY = std::max<int32_t>(centerPos.y - minYRange, 0), maxY = std::min<int32_t>(centerPos.y + maxYRange, UINT16_MAX - 1);
+
+    std::vector<IndexedCreature> found;
+    for (int32_t z = std::max<int32_t>(minZ, 0); z <= std::min<int32_t>(maxZ, MAX_Z); ++z) {
+        const auto& cells = m_creatureCells[z];
+        if (cells.empty())
+            continue;
+
+        for (int32_t cy = minY - minY % CREATURE_CELL_SIZE; cy <= maxY; cy += CREATURE_CELL_SIZE) {
+            for (int32_t cx = minX - minX % CREATURE_CELL_SIZE; cx <= maxX; cx += CREATURE_CELL_SIZE) {
+                const auto it = cells.find(getCreatureCellIndex(cx, cy));
+                if (it == cells.end())
+                    continue;
+
+                for (const IndexedCreature& entry : it->second) {
+                    const Position& pos = entry.position;
+                    if (pos.x >= minX && pos.x <= maxX && pos.y >= minY && pos.y <= maxY)
+                        found.push_back(entry);
                 }
             }
         }
     }
 
+    // keep the order of a floor by floor, row by row scan
+    std::stable_sort(found.begin(), found.end(), [](const IndexedCreature& a, const IndexedCreature& b) {
+        return std::tie(a.position.z, a.position.y, a.position.x) < std::tie(b.position.z, b.position.y, b.position.x);
+    });
+
+    // creatures sharing a tile come in the reverse of their order on it, as the scan read them
+    for (auto first = found.begin(); first != found.end();) {
+        const auto last = std::find_if(first + 1, found.end(), [&](const IndexedCreature& entry) { return entry.position != first->position; });
+        if (last - first > 1) {
+            if (const TilePtr& tile = getTile(first->position)) {
+                std::sort(first, last, [&tile](const IndexedCreature& a, const IndexedCreature& b) {
+                    return tile->getThingStackPos(a.creature) > tile->getThingStackPos(b.creature);
+                });
+            }
+        }
+        first = last;
+    }
+
+    std::vector<CreaturePtr> creatures;
+    creatures.reserve(found.size());
+    for (const IndexedCreature& entry : found)
+        creatures.push_back(entry.creature);
+
+    if (m_spectatorCacheEnabled) {
+        if (m_spectatorCache.size() >= MAX_CACHED_SPECTATOR_QUERIES)
+            m_spectatorCache.erase(m_spectatorCache.begin());
+        m_spectatorCache.push_back({ centerPos, multiFloor, minXRange, maxXRange, minYRange, maxYRange, creatures });
+    }
+
     return creatures;
 }
 
+void Map::indexCreature(const CreaturePtr& creature, const Position& pos)
+{
+    if (!pos.isMapPosition())
+        return;
+
+    m_creatureCells[pos.z][getCreatureCellIndex(pos.x, pos.y)].push_back({ creature, pos });
+    m_spectatorCache.clear();
+}
+
+void Map::unindexCreature(const CreaturePtr& creature, const Position& pos)
+{
+    if (!pos.isMapPosition())
+        return;
+
+    auto& cells = m_creatureCells[pos.z];
+    const auto it = cells.find(getCreatureCellIndex(pos.x, pos.y));
+    if (it == cells.end())
+        return;
+
+    auto& entries = it->second;
+    const auto entry = std::find_if(entries.begin(), entries.end(), [&](const IndexedCreature& e) { return e.creature == creature && e.position == pos; });
+    if (entry != entries.end())
+        entries.erase(entry);
+
+    if (entries.empty())
+        cells.erase(it);
+
+    m_spectatorCache.clear();
+}
+
 bool Map::isLookPossible(const Position& pos)
 {
     const TilePtr tile = getTile(pos);
@@ -732,6 +960,164 @@ void Map::setAwareRange(const AwareRange& range)
 {
     m_awareRange = range;
     removeUnawareThings();
+    m_spectatorCache.clear();
+
+    for (auto& grid : m_tileGrids)
+        grid.resize(m_awareRange.horizontal(), m_awareRange.vertical());
+    updateTileGrids(true);
+}
+
+void Map::setTileGridEnabled(bool enable)
+{
+    if (m_tileGridEnabled == enable)
+        return;
+
+    m_tileGridEnabled = enable;
+    updateTileGrids(true);
+}
+
+void Map::setGridTile(const Position& pos, const TilePtr& tile)
+{
+    if (!m_tileGridEnabled)
+        return;
+
+    TileGrid& grid = m_tileGrids[pos.z];
+    if (grid.contains(pos))
+        grid.at(pos) = tile;
+}
+
+void Map::updateTileGrids(bool refill)
+{
+    if (!m_tileGridEnabled) {
+        for (auto& grid : m_tileGrids)
+            grid.clear();
+        return;
+    }
+
+    if (!m_centralPosition.isValid())
+        return;
+
+    for (int_fast8_t z = -1; ++z <= MAX_Z;) {
+        TileGrid& grid = m_tileGrids[z];
+
+        // tiles of other floors are seen shifted by one sqm per floor, the spare room
+        // left by the power of two size is split around the aware area
+        const int32_t offset = m_centralPosition.z - z;
+        const int32_t x = m_centralPosition.x - m_awareRange.left + offset - (grid.getWidth() - m_awareRange.horizontal()) / 2;
+        const int32_t y = m_centralPosition.y - m_awareRange.top + offset - (grid.getHeight() - m_awareRange.vertical()) / 2;
+        if (!refill && x == grid.getX() && y == grid.getY())
+            continue;
+
+        // cells keep their tile while the position stays inside the window,
+        // only the positions that just entered it have to be fetched from the blocks
+        const int32_t oldX = grid.getX(), oldY = grid.getY();
+        grid.setOrigin(x, y);
+        for (int32_t iy = y; iy < y + grid.getHeight(); ++iy) {
+            for (int32_t ix = x; ix < x + grid.getWidth(); ++ix) {
+                if (!refill && static_cast<uint32_t>(ix - oldX) < grid.getWidth() && static_cast<uint32_t>(iy - oldY) < grid.getHeight())
+                    continue;
+
+                const Position pos(ix, iy, z);
+                if (ix < 0 || iy < 0 || ix > UINT16_MAX || iy > UINT16_MAX)
+                    grid.at(pos) = nullptr;
+                else
+                    grid.at(pos) = getBlockTile(pos);
+            }
+        }
+    }
+}
+
+std::map<std::string, double> Map::benchmarkTileLookup(uint32_t iterations)
+{
+    const bool tileGridEnabled = m_tileGridEnabled;
+    double lookups = 0;
+    double found = 0;
+
+    const auto run = [&] {
+        stdext::timer timer;
+        for (uint32_t i = 0; i < iterations; ++i) {
+            for (int_fast32_t z = getFirstAwareFloor(); z <= getLastAwareFloor(); ++z) {
+                const int32_t offset = m_centralPosition.z - z;
+                for (int32_t y = -m_awareRange.top; y <= m_awareRange.bottom; ++y) {
+                    for (int32_t x = -m_awareRange.left; x <= m_awareRange.right; ++x) {
+                        if (getTile(Position(m_centralPosition.x + x + offset, m_centralPosition.y + y + offset, z)))
+                            ++found;
+                        ++lookups;
+                    }
+                }
+            }
+        }
+        return std::max<double>(timer.elapsed_micros(), 1) * 1000.0;
+    };
+
+    setTileGridEnabled(false);
+    const double blockNanos = run();
+    setTileGridEnabled(true);
+    const double gridNanos = run();
+    setTileGridEnabled(tileGridEnabled);
+
+    lookups /= 2;
+    found /= 2;
+
+    return {
+        { "lookups", lookups },
+        { "tilesFound", found },
+        { "blockNanosPerLookup", lookups > 0 ? blockNanos / lookups : 0 },
+        { "gridNanosPerLookup", lookups > 0 ? gridNanos / lookups : 0 },
+        { "speedup", blockNanos / gridNanos }
+    };
+}
+
+std::map<std::string, double> Map::benchmarkTileAnalysis(uint32_t iterations)
+{
+    // the things of the scene around the camera, the same ones tile analysis walks through
+    std::vector<ThingPtr> things;
+    for (int_fast32_t z = getFirstAwareFloor(); z <= getLastAwareFloor(); ++z) {
+        const int32_t offset = m_centralPosition.z - z;
+        for (int32_t y = -m_awareRange.top; y <= m_awareRange.bottom; ++y) {
+            for (int32_t x = -m_awareRange.left; x <= m_awareRange.right; ++x) {
+                if (const TilePtr& tile = getTile(Position(m_centralPosition.x + x + offset, m_centralPosition.y + y + offset, z)))
+                    things.insert(things.end(), tile->getThings().begin(), tile->getThings().end());
+            }
+        }
+    }
+
+    uint64_t typeResult = 0;
+    stdext::timer typeTimer;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        for (const ThingPtr& thing : things) {
+            const ThingTypePtr& type = thing->getThingType();
+            typeResult += type->isGround() + type->isGroundBorder() + type->isOnBottom() + type->isOnTop() +
+                type->isNotWalkable() + type->isNotPathable() + type->blockProjectile() + type->isFullGround() +
+                type->hasElevation() + type->isSingleDimension();
+            if (thing->isItem())
+                typeResult += type->getElevation();
+        }
+    }
+    const double typeNanos = std::max<double>(typeTimer.elapsed_micros(), 1) * 1000.0;
+
+    uint64_t tableResult = 0;
+    stdext::timer tableTimer;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        for (const ThingPtr& thing : things) {
+            const uint64_t flags = thing->getThingFlags();
+            tableResult += hasThingFlag(flags, ThingAttrGround) + hasThingFlag(flags, ThingAttrGroundBorder) + hasThingFlag(flags, ThingAttrOnBottom) + hasThingFlag(flags, ThingAttrOnTop) +
+                hasThingFlag(flags, ThingAttrNotWalkable) + hasThingFlag(flags, ThingAttrNotPathable) + hasThingFlag(flags, ThingAttrBlockProjectile) + hasThingFlag(flags, ThingAttrFullGround) +
+                hasThingFlag(flags, ThingAttrElevation) + hasThingFlag(flags, ThingFlagSingleDimension);
+            if (thing->isItem())
+                tableResult += g_things.getThingElevation(thing->static_self_cast<Item>()->getClientId(), ThingCategoryItem);
+        }
+    }
+    const double tableNanos = std::max<double>(tableTimer.elapsed_micros(), 1) * 1000.0;
+
+    const double reads = static_cast<double>(things.size()) * iterations;
+    return {
+        { "things", static_cast<double>(things.size()) },
+        { "typeNanosPerThing", reads > 0 ? typeNanos / reads : 0 },
+        { "tableNanosPerThing", reads > 0 ? tableNanos / reads : 0 },
+        { "speedup", typeNanos / tableNanos },
+        { "matches", typeResult == tableResult ? 1. : 0. }
+    };
 }
 
 uint8_t Map::getFirstAwareFloor()
@@ -751,6 +1137,21 @@ uint8_t Map::getLastAwareFloor()
 }
 
 std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult> Map::findPath(const Position& startPos, const Position& goalPos, int maxComplexity, int flags)
+{
+    // reuse an entry only when this limit reproduces it: the search must fit in maxComplexity, and
+    // one that ran out of complexity may succeed with a higher limit, so it must have had this one
+    if (const auto* cached = m_pathCache.get(startPos, goalPos, flags); cached && cached->complexity <= maxComplexity
+        && (cached->status != Otc::PathFindResultTooFar || cached->complexity == maxComplexity))
+        return { cached->path, cached->status };
+
+    auto ret = m_pathFinder.find(startPos, goalPos, maxComplexity, flags);
+    const auto& [dirs, result] = ret;
+    m_pathCache.put(startPos, goalPos, flags, { result, dirs, result == Otc::PathFindResultTooFar ? maxComplexity : static_cast<int>(m_pathFinder.getLastComplexity()) });
+    return ret;
+}
+
+// the search findPath did before PathFinder, kept as the baseline of benchmarkFindPath
+std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult> Map::findPathReference(const Position& startPos, const Position& goalPos, int maxComplexity, int flags)
 {
     // pathfinding using dijkstra search algorithm
 
@@ -924,14 +1325,76 @@ std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult> Map::findPath(const
     return ret;
 }
 
+std::map<std::string, double> Map::benchmarkFindPath(uint32_t iterations, int maxComplexity)
+{
+    // the mismatch count reads the results of the last iteration
+    iterations = std::max<uint32_t>(iterations, 1);
+
+    // routes from the camera to points at growing distances in every direction
+    std::vector<Position> goals;
+    for (const int distance : { 16, 32, 64, 128 }) {
+        for (int i = -1; i <= 1; ++i) {
+            for (int j = -1; j <= 1; ++j) {
+                if (i != 0 || j != 0)
+                    goals.push_back(m_centralPosition.translated(i * distance, j * distance));
+            }
+        }
+    }
+
+    const Position start = m_centralPosition;
+    const auto run = [&](const std::function<std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult>(const Position&)>& find) {
+        std::vector<std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult>> results;
+        stdext::timer timer;
+        for (uint32_t i = 0; i < iterations; ++i) {
+            results.clear();
+            for (const Position& goal : goals)
+                results.push_back(find(goal));
+        }
+        return std::make_pair(std::max<double>(timer.elapsed_micros(), 1) * 1000.0, results);
+    };
+
+    const auto [referenceNanos, referenceResults] = run([&](const Position& goal) { return findPathReference(start, goal, maxComplexity, 0); });
+    const auto [gridNanos, gridResults] = run([&](const Position& goal) { return m_pathFinder.find(start, goal, maxComplexity, 0); });
+    const auto [jumpNanos, jumpResults] = run([&](const Position& goal) { return m_pathFinder.find(start, goal, maxComplexity, Otc::PathFindJumpPoints); });
+
+    // paths may differ between equally good alternatives, so results are compared by status and cost
+    const auto countMismatches = [&](const auto& results, int flags) {
+        double mismatches = 0;
+        for (size_t i = 0; i < goals.size(); ++i) {
+            const auto& [dirs, result] = results[i];
+            const auto& [referenceDirs, referenceResult] = referenceResults[i];
+            if (result != referenceResult)
+                ++mismatches;
+            else if (result == Otc::PathFindResultOk && std::abs(m_pathFinder.getPathCost(start, dirs, flags) - m_pathFinder.getPathCost(start, referenceDirs, flags)) > 0.01f)
+                ++mismatches;
+        }
+        return mismatches;
+    };
+
+    double found = 0;
+    for (const auto& [dirs, result] : referenceResults)
+        found += result == Otc::PathFindResultOk;
+
+    const double searches = static_cast<double>(goals.size()) * iterations;
+    return {
+        { "routes", static_cast<double>(goals.size()) },
+        { "found", found },
+        { "referenceMicrosPerRoute", referenceNanos / searches / 1000.0 },
+        { "gridMicrosPerRoute", gridNanos / searches / 1000.0 },
+        { "jumpPointMicrosPerRoute", jumpNanos / searches / 1000.0 },
+        { "gridMismatches", countMismatches(gridResults, 0) },
+        { "jumpPointMismatches", countMismatches(jumpResults, Otc::PathFindJumpPoints) }
+    };
+}
+
 void Map::resetLastCamera()
 {
     for (const MapViewPtr& mapView : m_mapViews)
         mapView->resetLastCamera();
 }
 
-PathFindResult_ptr Map::newFindPath(const Position& start, const Position& goal, const std::shared_ptr<std::list<Node*>>
-                                    & visibleNodes)
+PathFindResult_ptr Map::newFindPath(const Position& start, const Position& goal, const WalkSnapshotPtr& snapshot,
+                                    const PathFindRequestPtr& request)
 {
     auto ret = std::make_shared<PathFindResult>();
     ret->start = start;
@@ -945,19 +1408,32 @@ PathFindResult_ptr Map::newFindPath(const Position& start, const Position& goal,
         return ret;
     }
 
-    // check the goal pos is walkable
-    if (g_map.isAwareOfPosition(goal)) {
-        const TilePtr goalTile = getTile(goal);
-        if (!goalTile || (!goalTile->isWalkable())) {
+    // check the goal pos is walkable, the map itself is not safe to read from here
+    const WalkSnapshot::Entry* goalEntry = snapshot ? snapshot->getEntry(goal) : nullptr;
+    if (goalEntry) {
+        if (!goalEntry->hasFlag(WalkSnapshot::EntryWalkable)) {
             return ret;
         }
     } else {
-        const MinimapTile& goalTile = g_minimap.getTile(goal);
+        const MinimapTile goalTile = g_minimap.threadGetTile(goal).second;
         if (goalTile.hasFlag(MinimapTileNotWalkable)) {
             return ret;
         }
     }
 
+    // far goals are routed over the minimap clusters first and only the leg up to
+    // the first entrance that is far enough away is searched tile by tile
+    Position target = goal;
+    if (start.distance(goal) > MMBLOCK_SIZE) {
+        std::vector<Position> waypoints;
+        if (m_hierarchicalPathFinder.findRoute(start, goal, waypoints) == Otc::PathFindResultOk) {
+            const auto it = std::find_if(waypoints.begin(), waypoints.end(), [&](const Position& waypoint) {
+                return start.distance(waypoint) >= MMBLOCK_SIZE;
+            });
+            target = it != waypoints.end() ? *it : goal;
+        }
+    }
+
     struct LessNode
     {
         bool operator()(Node* a, Node* b) const
@@ -969,27 +1445,26 @@ PathFindResult_ptr Map::newFindPath(const Position& start, const Position& goal,
     stdext::map<Position, Node*, Position::Hasher> nodes;
     std::priority_queue<Node*, std::vector<Node*>, LessNode> searchList;
 
-    if (visibleNodes) {
-        for (auto& node : *visibleNodes)
-            nodes.emplace(node->pos, node);
-    }
-
     auto initNode = new Node{ 1, 0, start, nullptr, 0, 0 };
     nodes[start] = initNode;
     searchList.push(initNode);
 
     int limit = 50000;
-    const float distance = start.distance(goal);
+    const float distance = start.distance(target);
 
     Node* dstNode = nullptr;
     while (!searchList.empty() && --limit) {
+        // superseded requests stop early, their result is thrown away anyway
+        if (request && limit % 256 == 0 && request->isCanceled())
+            break;
+
         Node* node = searchList.top();
         searchList.pop();
-        if (node->pos == goal) {
+        if (node->pos == target) {
             dstNode = node;
             break;
         }
-        if (node->pos.distance(goal) > distance + 10000)
+        if (node->pos.distance(target) > distance + 10000)
             continue;
         for (int i = -1; i <= 1; ++i) {
             for (int j = -1; j <= 1; ++j) {
@@ -998,14 +1473,23 @@ PathFindResult_ptr Map::newFindPath(const Position& start, const Position& goal,
                 Position neighbor = node->pos.translated(i, j);
                 if (neighbor.x < 0 || neighbor.y < 0) continue;
                 auto it = nodes.find(neighbor);
-                if (it == nodes.end()) {
+                const WalkSnapshot::Entry* entry = it == nodes.end() && snapshot ? snapshot->getEntry(neighbor) : nullptr;
+                if (entry && entry->hasFlag(WalkSnapshot::EntryHasTile)) {
+                    const bool isNotWalkable = !entry->hasFlag(WalkSnapshot::EntryWalkable);
+                    const bool isNotPathable = !entry->hasFlag(WalkSnapshot::EntryPathable);
+                    if ((isNotWalkable || isNotPathable) && neighbor != target) {
+                        it = nodes.emplace(neighbor, nullptr).first;
+                    } else {
+                        it = nodes.emplace(neighbor, new Node{ static_cast<float>(entry->speed), 10000000.0f, neighbor, node, node->distance + 1, 0 }).first;
+                    }
+                } else if (it == nodes.end()) {
                     auto blockAndTile = g_minimap.threadGetTile(neighbor);
                     const bool wasSeen = blockAndTile.second.hasFlag(MinimapTileWasSeen);
                     const bool isNotWalkable = blockAndTile.second.hasFlag(MinimapTileNotWalkable);
                     const bool isNotPathable = blockAndTile.second.hasFlag(MinimapTileNotPathable);
                     const bool isEmpty = blockAndTile.second.hasFlag(MinimapTileEmpty);
                     float speed = blockAndTile.second.getSpeed();
-                    if ((isNotWalkable || isNotPathable || isEmpty) && neighbor != goal) {
+                    if ((isNotWalkable || isNotPathable || isEmpty) && neighbor != target) {
                         it = nodes.emplace(neighbor, nullptr).first;
                     } else {
                         if (!wasSeen)
@@ -1020,7 +1504,7 @@ PathFindResult_ptr Map::newFindPath(const Position& start, const Position& goal,
 
                 const float diagonal = ((i == 0 || j == 0) ? 1.0f : 3.0f);
                 float cost = it->second->cost * diagonal;
-                cost += diagonal * (50.0f * std::max<float>(5.0f, it->second->pos.distance(goal))); // heuristic
+                cost += diagonal * (50.0f * std::max<float>(5.0f, it->second->pos.distance(target))); // heuristic
                 if (node->totalCost + cost + 50 < it->second->totalCost) {
                     it->second->totalCost = node->totalCost + cost;
                     it->second->prev = node;
@@ -1054,25 +1538,46 @@ PathFindResult_ptr Map::newFindPath(const Position& start, const Position& goal,
     return ret;
 }
 
-void Map::findPathAsync(const Position& start, const Position& goal, const std::function<void(PathFindResult_ptr)>&
-                        callback)
+PathFindRequestPtr Map::findPathAsync(const Position& start, const Position& goal, const std::function<void(PathFindResult_ptr)>& callback)
 {
-    const auto visibleNodes = std::make_shared<std::list<Node*>>();
-    for (const auto& tile : getTiles(start.z)) {
-        if (tile->getPosition() == start)
-            continue;
-        const bool isNotWalkable = !tile->isWalkable(false);
-        const bool isNotPathable = !tile->isPathable();
-        const float speed = tile->getGroundSpeed();
-        if ((isNotWalkable || isNotPathable) && tile->getPosition() != goal) {
-            visibleNodes->push_back(new Node{ speed, 0, tile->getPosition(), nullptr, 0, 0 });
-        } else {
-            visibleNodes->push_back(new Node{ speed, 10000000.0f, tile->getPosition(), nullptr, 0, 0 });
-        }
+    if (const auto* cached = m_pathCache.get(start, goal, PathCache::ASYNC_SEARCH)) {
+        const auto request = std::make_shared<PathFindRequest>();
+        const auto result = std::make_shared<PathFindResult>();
+        result->status = cached->status;
+        result->path = cached->path;
+        result->complexity = cached->complexity;
+        result->start = start;
+        result->destination = goal;
+
+        // same as a searched path, the result arrives later and not if canceled meanwhile
+        g_dispatcher.addEvent([request, result, callback] {
+            if (!request->isCanceled())
+                callback(result);
+        });
+        return request;
     }
 
-    g_asyncDispatcher.dispatch([=] {
-        auto ret = g_map.newFindPath(start, goal, visibleNodes);
-        g_dispatcher.addEvent(std::bind(callback, ret));
+    // results are only kept when nothing changed on the floor while searching
+    const uint32_t version = getFloorVersion(start.z);
+    return m_pathFindService.find(start, goal, [this, version, callback](const PathFindResult_ptr& result) {
+        if (getFloorVersion(result->start.z) == version)
+            m_pathCache.put(result->start, result->destination, PathCache::ASYNC_SEARCH, { result->status, result->path, result->complexity });
+        callback(result);
     });
 }
+
+uint64_t Map::getRegionVersion(const Position& pos)
+{
+    if (pos.z > MAX_Z)
+        return 0;
+
+    const auto it = m_regionVersions[pos.z].find(getRegionIndex(pos));
+    const uint64_t mapVersion = it != m_regionVersions[pos.z].end() ? it->second : 0;
+    return mapVersion << 32 | g_minimap.threadGetBlockVersion(pos);
+}
+
+void Map::updateMapVersion(const Position& pos)
+{
+    m_regionVersions[pos.z][getRegionIndex(pos)] = ++m_mapVersion;
+    m_floorVersions[pos.z] = m_mapVersion;
+}
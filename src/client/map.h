@@ -24,8 +24,15 @@
 
 #include "animatedtext.h"
 #include "creatures.h"
+#include "hierarchicalpathfinder.h"
+#include "itemtype.h"
+#include "pathcache.h"
+#include "pathfinder.h"
+#include "pathfindservice.h"
 #include "tile.h"
 
+#include <bit>
+
 enum OTBM_ItemAttr
 {
     OTBM_ATTR_DESCRIPTION = 1,
@@ -86,7 +93,9 @@ enum
 
 enum
 {
-    BLOCK_SIZE = 32
+    BLOCK_SIZE = 32,
+    CREATURE_CELL_SIZE = 8,
+    MAX_CACHED_SPECTATOR_QUERIES = 16
 };
 
 enum : uint8_t
@@ -124,15 +133,37 @@ private:
     std::array<TilePtr, BLOCK_SIZE* BLOCK_SIZE> m_tiles;
 };
 
-struct PathFindResult
+// wrap-around window over the tiles of one floor that follows the camera,
+// it mirrors the tile blocks so lookups inside it are plain array indexing
+class TileGrid
 {
-    Otc::PathFindResult status = Otc::PathFindResultNoWay;
-    std::vector<Otc::Direction> path;
-    int complexity = 0;
-    Position start;
-    Position destination;
+public:
+    void resize(uint16_t width, uint16_t height)
+    {
+        m_width = std::bit_ceil(width);
+        m_height = std::bit_ceil(height);
+        m_tiles.assign(m_width * m_height, nullptr);
+    }
+    void clear() { std::fill(m_tiles.begin(), m_tiles.end(), nullptr); }
+
+    void setOrigin(int32_t x, int32_t y) { m_x = x; m_y = y; }
+    bool contains(int32_t x, int32_t y) const { return static_cast<uint32_t>(x - m_x) < m_width && static_cast<uint32_t>(y - m_y) < m_height; }
+    bool contains(const Position& pos) const { return contains(pos.x, pos.y); }
+
+    TilePtr& at(const Position& pos) { return m_tiles[((pos.y & (m_height - 1)) * m_width) + (pos.x & (m_width - 1))]; }
+
+    int32_t getX() const { return m_x; }
+    int32_t getY() const { return m_y; }
+    uint16_t getWidth() const { return m_width; }
+    uint16_t getHeight() const { return m_height; }
+
+private:
+    std::vector<TilePtr> m_tiles;
+    int32_t m_x{ 0 };
+    int32_t m_y{ 0 };
+    uint16_t m_width{ 0 };
+    uint16_t m_height{ 0 };
 };
-using PathFindResult_ptr = std::shared_ptr<PathFindResult>;
 
 struct Node
 {
@@ -201,6 +232,12 @@ public:
     const TileList getTiles(int8_t floor = -1);
     void cleanTile(const Position& pos);
 
+    // keeps the tiles around the camera in wrap-around grids, other tiles are still looked up in the blocks
+    void setTileGridEnabled(bool enable);
+    bool isTileGridEnabled() { return m_tileGridEnabled; }
+    std::map<std::string, double> benchmarkTileLookup(uint32_t iterations);
+    std::map<std::string, double> benchmarkTileAnalysis(uint32_t iterations);
+
     // tile zone related
     void setShowZone(tileflags_t zone, bool show);
     void setShowZones(bool show);
@@ -223,6 +260,16 @@ public:
     void endGhostMode();
 
     std::map<Position, ItemPtr> findItemsById(uint16_t clientId, uint32_t max);
+    std::vector<ItemPtr> findItemsByIdRange(uint16_t firstClientId, uint16_t lastClientId, uint32_t max);
+    std::vector<ItemPtr> findItemsByAttr(ThingAttr attr, uint32_t max);
+    std::vector<ItemPtr> findItemsByCategory(ItemCategory category, uint32_t max);
+
+    // index of the items on the map by client id, it makes item searches independent of the map size
+    // at the cost of one entry per item, so it is off unless enabled
+    void setItemIndexEnabled(bool enable);
+    bool isItemIndexEnabled() { return m_itemIndexEnabled; }
+    void indexItem(const ItemPtr& item, const Position& pos);
+    void unindexItem(const ItemPtr& item, const Position& pos);
 
     // known creature related
     void addCreature(const CreaturePtr& creature);
@@ -233,6 +280,14 @@ public:
     std::vector<CreaturePtr> getSpectatorsInRange(const Position& centerPos, bool multiFloor, int32_t xRange, int32_t yRange);
     std::vector<CreaturePtr> getSpectatorsInRangeEx(const Position& centerPos, bool multiFloor, int32_t minXRange, int32_t maxXRange, int32_t minYRange, int32_t maxYRange);
 
+    // creatures standing on tiles, bucketed by floor and cell, kept up to date by Tile
+    void indexCreature(const CreaturePtr& creature, const Position& pos);
+    void unindexCreature(const CreaturePtr& creature, const Position& pos);
+
+    // identical spectator queries reuse the last result until a creature changes tile or the camera moves
+    void setSpectatorCacheEnabled(bool enable) { m_spectatorCacheEnabled = enable; m_spectatorCache.clear(); }
+    bool isSpectatorCacheEnabled() { return m_spectatorCacheEnabled; }
+
     void setLight(const Light& light);
 
     void setCentralPosition(const Position& centralPosition);
@@ -259,17 +314,56 @@ public:
 
     std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult> findPath(const Position& start, const Position& goal,
                                                                           int maxComplexity, int flags = 0);
-    PathFindResult_ptr newFindPath(const Position& start, const Position& goal, const std::shared_ptr<std::list<Node*>>& visibleNodes);
-    void findPathAsync(const Position& start, const Position& goal,
-                       const std::function<void(PathFindResult_ptr)>& callback);
+    std::map<std::string, double> benchmarkFindPath(uint32_t iterations, int maxComplexity);
+    PathFindResult_ptr newFindPath(const Position& start, const Position& goal, const WalkSnapshotPtr& snapshot,
+                                   const PathFindRequestPtr& request = nullptr);
+    PathFindRequestPtr findPathAsync(const Position& start, const Position& goal,
+                                     const std::function<void(PathFindResult_ptr)>& callback);
+    std::map<std::string, double> getPathFindStats() { return m_pathFindService.getStats(); }
+    void resetPathFindStats() { m_pathFindService.resetStats(); }
+
+    // bumped by every change of items or creatures on a floor or in a region of it
+    uint32_t getFloorVersion(uint8_t z) const { return z <= MAX_Z ? m_floorVersions[z] : 0; }
+    uint64_t getRegionVersion(const Position& pos);
+    bool isSameRegion(const Position& a, const Position& b) const { return a.z == b.z && a.x / BLOCK_SIZE == b.x / BLOCK_SIZE && a.y / BLOCK_SIZE == b.y / BLOCK_SIZE; }
+
+    void setPathCacheEnabled(bool enable) { m_pathCache.setEnabled(enable); }
+    bool isPathCacheEnabled() { return m_pathCache.isEnabled(); }
+    void clearPathCache() { m_pathCache.clear(); }
+    std::map<std::string, double> getPathCacheStats() { return m_pathCache.getStats(); }
+    void resetPathCacheStats() { m_pathCache.resetStats(); }
 
     void setFloatingEffect(bool enable) { m_floatingEffect = enable; }
     bool isDrawingFloatingEffects() { return m_floatingEffect; }
 
 private:
     void removeUnawareThings();
+    std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult> findPathReference(const Position& start, const Position& goal,
+                                                                                   int maxComplexity, int flags);
+    void unindexTile(const TilePtr& tile);
+    void updateMapVersion(const Position& pos);
+    uint32_t getRegionIndex(const Position& pos) const { return (pos.y / BLOCK_SIZE) * (65536 / BLOCK_SIZE) + pos.x / BLOCK_SIZE; }
+    std::vector<ItemPtr> findItems(const std::function<bool(uint16_t)>& filter, uint32_t max);
+    void updateTileGrids(bool refill = false);
+    void setGridTile(const Position& pos, const TilePtr& tile);
+    const TilePtr& getBlockTile(const Position& pos);
 
     uint16_t getBlockIndex(const Position& pos) { return ((pos.y / BLOCK_SIZE) * (65536 / BLOCK_SIZE)) + (pos.x / BLOCK_SIZE); }
+    uint32_t getCreatureCellIndex(int32_t x, int32_t y) { return ((y / CREATURE_CELL_SIZE) * (65536 / CREATURE_CELL_SIZE)) + (x / CREATURE_CELL_SIZE); }
+
+    struct IndexedCreature
+    {
+        CreaturePtr creature;
+        Position position;
+    };
+
+    struct SpectatorQuery
+    {
+        Position centerPos;
+        bool multiFloor;
+        int32_t minXRange, maxXRange, minYRange, maxYRange;
+        std::vector<CreaturePtr> creatures;
+    };
 
     std::array<std::vector<MissilePtr>, MAX_Z + 1> m_floorMissiles;
 
@@ -278,7 +372,18 @@ private:
     std::vector<MapViewPtr> m_mapViews;
 
     stdext::map<uint32_t, TileBlock> m_tileBlocks[MAX_Z + 1];
+    std::array<TileGrid, MAX_Z + 1> m_tileGrids;
     stdext::map<uint32_t, CreaturePtr> m_knownCreatures;
+    stdext::map<uint32_t, std::vector<IndexedCreature>> m_creatureCells[MAX_Z + 1];
+    std::vector<SpectatorQuery> m_spectatorCache;
+    stdext::map<uint16_t, std::vector<std::pair<Position, ItemPtr>>> m_itemIndex;
+    PathFinder m_pathFinder;
+    HierarchicalPathFinder m_hierarchicalPathFinder;
+    PathFindService m_pathFindService;
+    PathCache m_pathCache;
+    uint32_t m_mapVersion{ 0 };
+    uint32_t m_floorVersions[MAX_Z + 1]{};
+    stdext::map<uint32_t, uint32_t> m_regionVersions[MAX_Z + 1];
     stdext::map<Position, std::string, Position::Hasher> m_waypoints;
 
     stdext::map<uint32_t, Color> m_zoneColors;
@@ -297,6 +402,9 @@ private:
     static TilePtr m_nulltile;
 
     bool m_floatingEffect{ true };
+    bool m_tileGridEnabled{ true };
+    bool m_spectatorCacheEnabled{ true };
+    bool m_itemIndexEnabled{ false };
 };
 
 extern Map g_map;
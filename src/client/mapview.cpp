@@ -30,6 +30,7 @@
 #include "missile.h"
 #include "shadermanager.h"
 #include "statictext.h"
+#include "thingtypemanager.h"
 #include "tile.h"
 
 #include <framework/core/application.h>
@@ -151,6 +152,10 @@ void MapView::drawFloor()
         if (m_drawHealthBars) { flags |= Otc::DrawBars; }
         if (m_drawManaBar) { flags |= Otc::DrawManaBar; }
 
+        // textures not composed yet are composed from the camera outwards
+        auto& composer = g_things.getTextureComposer();
+        composer.setFocus(transformPositionTo2D(cameraPosition, cameraPosition));
+
         for (int_fast8_t z = m_floorMax; z >= m_floorMin; --z) {
             float fadeLevel = getFadeLevel(z);
             if (fadeLevel == 0.f) break;
@@ -210,6 +215,8 @@ void MapView::drawFloor()
             g_drawPool.flush();
         }
 
+        composer.clearFocus();
+
         if (m_posInfo.rect.contains(g_window.getMousePosition())) {
             if (m_crosshairTexture) {
                 const Point& point = transformPositionTo2D(m_mousePosition, cameraPosition);
@@ -336,63 +343,159 @@ void MapView::updateVisibleTiles()
         }
     }
 
+    const Position lastCameraPosition = m_lastCameraPosition;
     m_lastCameraPosition = cameraPosition;
 
     const bool fadeFinished = getFadeLevel(m_cachedFirstVisibleFloor) == 1.f;
 
+    const VisibleTilesState state{ m_drawDimension, cameraPosition.z, cachedFirstVisibleFloor, m_cachedLastVisibleFloor,
+                                   m_cachedFirstVisibleFloor, fadeFinished, isDrawingLights() };
+
+    // a camera step or a few tile updates only change some cells, anything else evaluates all of them
+    const bool patched = m_incrementalVisibleTiles && !m_rebuildVisibleTiles && !m_resetCoveredCache && state == m_visibleTilesState
+        && shiftVisibleTiles(cameraPosition, lastCameraPosition, fadeFinished) && patchVisibleTiles(cameraPosition, fadeFinished);
+
+    if (!patched) {
+        m_visibleTilesState = state;
+        for (int_fast32_t iz = m_cachedLastVisibleFloor; iz >= cachedFirstVisibleFloor; --iz) {
+            auto& grid = m_cachedVisibleTiles[iz].grid;
+            grid.assign(getVisibleCellCount(), {});
+            forEachVisibleCell([&](int ix, int iy) {
+                updateVisibleTile(grid[getVisibleCellIndex(ix, iy)], getVisibleCellPosition(ix, iy, iz, cameraPosition), cameraPosition, fadeFinished, m_resetCoveredCache);
+            });
+        }
+    }
+
+    m_updatedTiles.clear();
+
     // cache visible tiles in draw order
     // draw from last floor (the lower) to first floor (the higher)
-    const uint32_t numDiagonals = m_drawDimension.width() + m_drawDimension.height() - 1;
     for (int_fast32_t iz = m_cachedLastVisibleFloor; iz >= cachedFirstVisibleFloor; --iz) {
         auto& floor = m_cachedVisibleTiles[iz];
+        forEachVisibleCell([&](int ix, int iy) {
+            const VisibleTile& cell = floor.grid[getVisibleCellIndex(ix, iy)];
+            if (!cell.tile)
+                return;
+
+            if (cell.draw)
+                floor.tiles.emplace_back(cell.tile);
+
+            if (cell.shade)
+                floor.shades.emplace_back(cell.tile);
+
+            if (cell.draw || !floor.shades.empty()) {
+                if (iz < m_floorMin)
+                    m_floorMin = iz;
+                else if (iz > m_floorMax)
+                    m_floorMax = iz;
+            }
+        });
+    }
 
-        // loop through / diagonals beginning at top left and going to top right
-        for (uint_fast32_t diagonal = 0; diagonal < numDiagonals; ++diagonal) {
-            // loop current diagonal tiles
-            const uint32_t advance = std::max<uint32_t >(diagonal - m_drawDimension.height(), 0);
-            for (int iy = diagonal - advance, ix = advance; iy >= 0 && ix < m_drawDimension.width(); --iy, ++ix) {
-                // position on current floor
-                //TODO: check position limits
-                Position tilePos = cameraPosition.translated(ix - m_virtualCenterOffset.x, iy - m_virtualCenterOffset.y);
-                // adjust tilePos to the wanted floor
-                tilePos.coveredUp(cameraPosition.z - iz);
-                if (const TilePtr& tile = g_map.getTile(tilePos)) {
-                    // skip tiles that have nothing
-                    if (!tile->isDrawable())
-                        continue;
+    m_updateVisibleTiles = false;
+    m_rebuildVisibleTiles = false;
+    m_resetCoveredCache = false;
+}
 
-                    bool addTile = true;
+void MapView::updateVisibleTile(VisibleTile& cell, const Position& tilePos, const Position& cameraPosition, bool fadeFinished, bool resetCoveredCache)
+{
+    cell = {};
 
-                    if (fadeFinished) {
-                        // skip tiles that are completely behind another tile
-                        if (tile->isCompletelyCovered(m_cachedFirstVisibleFloor, m_resetCoveredCache)) {
-                            if (m_floorViewMode != ALWAYS_WITH_TRANSPARENCY || (tilePos.z < cameraPosition.z && tile->isCovered(m_cachedFirstVisibleFloor))) {
-                                addTile = false;
-                            }
-                        }
-                    }
+    const TilePtr& tile = g_map.getTile(tilePos);
 
-                    if (addTile) {
-                        floor.tiles.emplace_back(tile);
-                        tile->onAddInMapView();
-                    }
+    // skip tiles that have nothing
+    if (!tile || !tile->isDrawable())
+        return;
 
-                    if (isDrawingLights() && tile->canShade(this))
-                        floor.shades.emplace_back(tile);
+    bool addTile = true;
 
-                    if (addTile || !floor.shades.empty()) {
-                        if (iz < m_floorMin)
-                            m_floorMin = iz;
-                        else if (iz > m_floorMax)
-                            m_floorMax = iz;
-                    }
+    if (fadeFinished) {
+        // skip tiles that are completely behind another tile
+        if (tile->isCompletelyCovered(m_cachedFirstVisibleFloor, resetCoveredCache)) {
+            if (m_floorViewMode != ALWAYS_WITH_TRANSPARENCY || (tilePos.z < cameraPosition.z && tile->isCovered(m_cachedFirstVisibleFloor))) {
+                addTile = false;
+            }
+        }
+    }
+
+    if (addTile)
+        tile->onAddInMapView();
+
+    cell.tile = tile;
+    cell.draw = addTile;
+    cell.shade = isDrawingLights() && tile->canShade(this);
+}
+
+bool MapView::shiftVisibleTiles(const Position& cameraPosition, const Position& lastCameraPosition, bool fadeFinished)
+{
+    if (!lastCameraPosition.isValid() || lastCameraPosition.z != cameraPosition.z)
+        return false;
+
+    const int dx = cameraPosition.x - lastCameraPosition.x;
+    const int dy = cameraPosition.y - lastCameraPosition.y;
+    if (dx == 0 && dy == 0)
+        return true;
+
+    if (std::abs(dx) > 1 || std::abs(dy) > 1)
+        return false;
+
+    for (int_fast32_t iz = m_visibleTilesState.lastFloor; iz >= m_visibleTilesState.firstFloor; --iz) {
+        auto& grid = m_cachedVisibleTiles[iz].grid;
+        m_shiftedVisibleTiles.assign(grid.size(), {});
+
+        forEachVisibleCell([&](int ix, int iy) {
+            VisibleTile& cell = m_shiftedVisibleTiles[getVisibleCellIndex(ix, iy)];
+
+            // cells that were at the edge are evaluated again as well, whether a tile shades
+            // depends on its neighbors being in range
+            const int ox = ix + dx, oy = iy + dy;
+            if (isVisibleCell(ox - 1, oy - 1) && isVisibleCell(ox + 1, oy - 1) && isVisibleCell(ox - 1, oy + 1) && isVisibleCell(ox + 1, oy + 1))
+                cell = std::move(grid[getVisibleCellIndex(ox, oy)]);
+            else
+                updateVisibleTile(cell, getVisibleCellPosition(ix, iy, iz, cameraPosition), cameraPosition, fadeFinished, false);
+        });
+
+        grid.swap(m_shiftedVisibleTiles);
+    }
+
+    return true;
+}
+
+bool MapView::patchVisibleTiles(const Position& cameraPosition, bool fadeFinished)
+{
+    if (m_updatedTiles.empty())
+        return true;
+
+    // a tile decides whether the tiles east and south of it shade and whether
+    // the tiles below it, on every floor down, are completely covered. A lying
+    // corpse also hides the creatures and top items of the tiles west and north
+    // of it, those need to be added again when the corpse goes away
+    std::vector<std::tuple<int, int, int>> cells;
+    for (const Position& pos : m_updatedTiles) {
+        for (int iz = std::max<int>(pos.z, m_visibleTilesState.firstFloor); iz <= m_visibleTilesState.lastFloor; ++iz) {
+            const int below = iz - pos.z;
+            for (int ox = -1; ox <= 1; ++ox) {
+                for (int oy = -1; oy <= 1; ++oy) {
+                    const int ix = pos.x - below + ox - cameraPosition.x + m_virtualCenterOffset.x - (cameraPosition.z - iz);
+                    const int iy = pos.y - below + oy - cameraPosition.y + m_virtualCenterOffset.y - (cameraPosition.z - iz);
+                    if (isVisibleCell(ix, iy))
+                        cells.emplace_back(-iz, ix + iy, ix);
                 }
             }
         }
     }
 
-    m_updateVisibleTiles = false;
-    m_resetCoveredCache = false;
+    // same order as a rebuild, tiles update the tiles they redraw when added
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+    for (const auto& [z, diagonal, ix] : cells) {
+        const int iy = diagonal - ix;
+        auto& grid = m_cachedVisibleTiles[-z].grid;
+        updateVisibleTile(grid[getVisibleCellIndex(ix, iy)], getVisibleCellPosition(ix, iy, -z, cameraPosition), cameraPosition, fadeFinished, false);
+    }
+
+    return true;
 }
 
 void MapView::updateGeometry(const Size& visibleDimension)
@@ -462,14 +565,23 @@ void MapView::onFloorChange(const uint8_t /*floor*/, const uint8_t /*previousFlo
     updateLight();
 }
 
-void MapView::onTileUpdate(const Position&, const ThingPtr& thing, const Otc::Operation op)
+void MapView::onTileUpdate(const Position& pos, const ThingPtr& thing, const Otc::Operation op)
 {
     if (thing) {
         if (thing->isOpaque() && op == Otc::OPERATION_REMOVE)
             m_resetCoveredCache = true;
+
+        // corpses wider than two tiles reach past the neighbors a patch updates
+        if (thing->isLyingCorpse() && (thing->getWidth() > 2 || thing->getHeight() > 2))
+            m_rebuildVisibleTiles = true;
     }
 
-    requestUpdateVisibleTiles();
+    if (m_updatedTiles.size() < MAX_PATCHED_TILE_UPDATES)
+        m_updatedTiles.push_back(pos);
+    else
+        m_rebuildVisibleTiles = true;
+
+    m_updateVisibleTiles = true;
 }
 
 void MapView::onFadeInFinished()
@@ -505,7 +617,8 @@ void MapView::onKeyRelease(const InputEvent& inputEvent)
 
 void MapView::onMapCenterChange(const Position& /*newPos*/, const Position& /*oldPos*/)
 {
-    requestUpdateVisibleTiles();
+    // the camera step is found by updateVisibleTiles, which rebuilds when it is too long
+    m_updateVisibleTiles = true;
 }
 
 void MapView::lockFirstVisibleFloor(uint8_t firstVisibleFloor)
@@ -633,7 +746,7 @@ void MapView::move(int32_t x, int32_t y)
     requestUpdateMapPosInfo();
 
     if (requestTilesUpdate)
-        requestUpdateVisibleTiles();
+        m_updateVisibleTiles = true;
 
     onCameraMove(m_moveOffset);
 }
@@ -133,6 +133,10 @@ public:
     void setDrawManaBar(bool enable) { m_drawManaBar = enable; }
     bool isDrawingManaBar() { return m_drawManaBar; }
 
+    // camera steps and tile updates patch the visible tiles instead of rebuilding them
+    void setIncrementalVisibleTiles(bool enable) { m_incrementalVisibleTiles = enable; requestUpdateVisibleTiles(); }
+    bool isIncrementalVisibleTiles() { return m_incrementalVisibleTiles; }
+
     void move(int32_t x, int32_t y);
 
     void setShader(const PainterShaderProgramPtr& shader, float fadein, float fadeout);
@@ -185,12 +189,38 @@ protected:
     friend class LightView;
 
 private:
+    // more tile updates than this between two frames are cheaper to handle with a rebuild
+    static constexpr size_t MAX_PATCHED_TILE_UPDATES = 64;
+
+    struct VisibleTile
+    {
+        TilePtr tile;
+        bool draw{ false },
+            shade{ false };
+    };
+
     struct MapObject
     {
         std::vector<TilePtr> shades, tiles;
+        // every cell of the draw dimension, as evaluated by the last update
+        std::vector<VisibleTile> grid;
         void clear() { shades.clear(); tiles.clear(); }
     };
 
+    // what the cells of the grids were evaluated with, they can only be reused while it holds
+    struct VisibleTilesState
+    {
+        Size drawDimension;
+        uint8_t z{ UINT8_MAX },
+            firstFloor{ 0 },
+            lastFloor{ 0 },
+            cachedFirstVisibleFloor{ 0 };
+        bool fadeFinished{ false },
+            drawLights{ false };
+
+        bool operator==(const VisibleTilesState& other) const = default;
+    };
+
     struct Crosshair
     {
         bool positionChanged = false;
@@ -200,7 +230,33 @@ private:
 
     void updateGeometry(const Size& visibleDimension);
     void updateVisibleTiles();
-    void requestUpdateVisibleTiles() { m_updateVisibleTiles = true; }
+    void updateVisibleTile(VisibleTile& cell, const Position& tilePos, const Position& cameraPosition, bool fadeFinished, bool resetCoveredCache);
+    bool shiftVisibleTiles(const Position& cameraPosition, const Position& lastCameraPosition, bool fadeFinished);
+    bool patchVisibleTiles(const Position& cameraPosition, bool fadeFinished);
+    void requestUpdateVisibleTiles() { m_updateVisibleTiles = m_rebuildVisibleTiles = true; }
+
+    // cells are walked in diagonals from the top left, which also covers some tiles left of and below
+    // the draw dimension, so the grids reserve a column for each row and one row more
+    template<class F>
+    void forEachVisibleCell(const F& f)
+    {
+        const uint32_t numDiagonals = m_drawDimension.width() + m_drawDimension.height() - 1;
+        for (uint_fast32_t diagonal = 0; diagonal < numDiagonals; ++diagonal) {
+            const uint32_t advance = std::max<uint32_t >(diagonal - m_drawDimension.height(), 0);
+            for (int iy = diagonal - advance, ix = advance; iy >= 0 && ix < m_drawDimension.width(); --iy, ++ix)
+                f(ix, iy);
+        }
+    }
+
+    bool isVisibleCell(int ix, int iy) { return iy >= 0 && iy <= m_drawDimension.height() && ix >= -iy && ix < m_drawDimension.width(); }
+    size_t getVisibleCellCount() { return static_cast<size_t>(m_drawDimension.width() + m_drawDimension.height()) * (m_drawDimension.height() + 1); }
+    size_t getVisibleCellIndex(int ix, int iy) { return static_cast<size_t>(iy) * (m_drawDimension.width() + m_drawDimension.height()) + ix + m_drawDimension.height(); }
+    Position getVisibleCellPosition(int ix, int iy, int z, const Position& cameraPosition)
+    {
+        Position tilePos = cameraPosition.translated(ix - m_virtualCenterOffset.x, iy - m_virtualCenterOffset.y);
+        tilePos.coveredUp(cameraPosition.z - z);
+        return tilePos;
+    }
     void requestUpdateMapPosInfo() { m_posInfo.rect = {}; }
 
     uint8_t calcFirstVisibleFloor(bool checkLimitsFloorsView);
@@ -269,6 +325,8 @@ private:
     bool
         m_limitVisibleDimension{ true },
         m_updateVisibleTiles{ true },
+        m_rebuildVisibleTiles{ true },
+        m_incrementalVisibleTiles{ true },
         m_resetCoveredCache{ true },
         m_shaderSwitchDone{ true },
         m_drawHealthBars{ true },
@@ -285,6 +343,9 @@ private:
         m_shiftPressed{ false };
 
     std::array<MapObject, MAX_Z + 1> m_cachedVisibleTiles;
+    VisibleTilesState m_visibleTilesState;
+    std::vector<Position> m_updatedTiles;
+    std::vector<VisibleTile> m_shiftedVisibleTiles;
 
     stdext::timer m_fadingFloorTimers[MAX_Z + 1];
 
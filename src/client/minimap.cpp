@@ -28,15 +28,27 @@
 #include <framework/graphics/drawpoolmanager.h>
 #include <framework/graphics/image.h>
 #include <framework/graphics/texture.h>
+#include <framework/graphics/texturemanager.h>
 #include <zlib.h>
 
 Minimap g_minimap;
 
+namespace
+{
+    std::atomic<uint32_t> lastWalkVersion{ 0 };
+}
+
 void MinimapBlock::clean()
 {
     m_tiles.fill(MinimapTile());
     m_texture.reset();
     m_mustUpdate = false;
+    walkabilityChanged();
+}
+
+void MinimapBlock::walkabilityChanged()
+{
+    m_walkVersion = ++lastWalkVersion;
 }
 
 void MinimapBlock::update()
@@ -74,15 +86,33 @@ void MinimapBlock::update()
     m_mustUpdate = false;
 }
 
+bool MinimapBlock::evictTexture(ticks_t lastUse)
+{
+    if (!m_texture || m_texture->getLastUse() >= lastUse)
+        return false;
+
+    // the tiles are kept, the image is built again from them when the block is drawn
+    m_texture.reset();
+    m_image.reset();
+    m_mustUpdate = true;
+    return true;
+}
+
 void MinimapBlock::updateTile(int x, int y, const MinimapTile& tile)
 {
-    if (m_tiles[getTileIndex(x, y)].color != tile.color)
+    const MinimapTile& oldTile = m_tiles[getTileIndex(x, y)];
+    if (oldTile.color != tile.color)
         m_mustUpdate = true;
+    if (oldTile.flags != tile.flags || oldTile.speed != tile.speed)
+        walkabilityChanged();
 
     m_tiles[getTileIndex(x, y)] = tile;
 }
 
-void Minimap::init() {}
+void Minimap::init()
+{
+    g_textures.addEvictor([this](ticks_t lastUse) { return evictTextures(lastUse); });
+}
 void Minimap::terminate() { clean(); }
 
 void Minimap::clean()
@@ -92,6 +122,21 @@ void Minimap::clean()
         m_tileBlocks[i].clear();
 }
 
+uint32_t Minimap::evictTextures(ticks_t lastUse)
+{
+    std::lock_guard lock(m_lock);
+
+    uint32_t evicted = 0;
+    for (const auto& blocks : m_tileBlocks) {
+        for (const auto& [index, block] : blocks) {
+            if (block->evictTexture(lastUse))
+                ++evicted;
+        }
+    }
+
+    return evicted;
+}
+
 void Minimap::draw(const Rect& screenRect, const Position& mapCenter, float scale, const Color& color)
 {
     if (screenRect.isEmpty())
@@ -228,6 +273,31 @@ std::pair<MinimapBlock_ptr, MinimapTile> Minimap::threadGetTile(const Position&
     return std::make_pair(nullptr, nulltile);
 }
 
+uint32_t Minimap::threadGetBlockVersion(const Position& pos)
+{
+    std::lock_guard lock(m_lock);
+    if (pos.z > MAX_Z)
+        return 0;
+
+    const auto it = m_tileBlocks[pos.z].find(getBlockIndex(pos));
+    return it != m_tileBlocks[pos.z].end() && it->second ? it->second->getWalkVersion() : 0;
+}
+
+uint32_t Minimap::threadGetBlockTiles(const Position& pos, std::array<MinimapTile, MMBLOCK_SIZE* MMBLOCK_SIZE>& tiles)
+{
+    std::lock_guard lock(m_lock);
+    if (pos.z <= MAX_Z) {
+        const auto it = m_tileBlocks[pos.z].find(getBlockIndex(pos));
+        if (it != m_tileBlocks[pos.z].end() && it->second) {
+            tiles = it->second->getTiles();
+            return it->second->getWalkVersion();
+        }
+    }
+
+    tiles.fill(MinimapTile());
+    return 0;
+}
+
 bool Minimap::loadImage(const std::string& fileName, const Position& topLeft, float colorFactor)
 {
     // non pathable colors
@@ -294,6 +364,7 @@ bool Minimap::loadImage(const std::string& fileName, const Position& topLeft, fl
                     tile.color = c;
                     tile.flags = flags;
                     block.mustUpdate();
+                    block.walkabilityChanged();
                 }
             }
         }
@@ -364,6 +435,7 @@ bool Minimap::loadOtmm(const std::string& fileName)
 
             memcpy(reinterpret_cast<uint8_t*>(&block.getTiles()), decompressBuffer.data(), blockSize);
             block.mustUpdate();
+            block.walkabilityChanged();
             block.justSaw();
         }
 
@@ -52,8 +52,11 @@ struct MinimapTile
 class MinimapBlock
 {
 public:
+    MinimapBlock() { walkabilityChanged(); }
+
     void clean();
     void update();
+    bool evictTexture(ticks_t lastUse);
     void updateTile(int x, int y, const MinimapTile& tile);
     MinimapTile& getTile(int x, int y) { return m_tiles[getTileIndex(x, y)]; }
     void resetTile(int x, int y) { m_tiles[getTileIndex(x, y)] = MinimapTile(); }
@@ -63,6 +66,8 @@ public:
     void mustUpdate() { m_mustUpdate = true; }
     void justSaw() { m_wasSeen = true; }
     bool wasSeen() { return m_wasSeen; }
+    void walkabilityChanged();
+    uint32_t getWalkVersion() const { return m_walkVersion; }
 private:
     TexturePtr m_texture;
     ImagePtr m_image;
@@ -71,6 +76,9 @@ private:
 
     std::array<MinimapTile, MMBLOCK_SIZE* MMBLOCK_SIZE> m_tiles;
 
+    // changes whenever flags or speed of a tile change, unique across blocks
+    uint32_t m_walkVersion{ 0 };
+
     bool m_mustUpdate{ true },
         m_wasSeen{ false };
 };
@@ -86,6 +94,7 @@ public:
     void terminate();
 
     void clean();
+    uint32_t evictTextures(ticks_t lastUse);
 
     void draw(const Rect& screenRect, const Position& mapCenter, float scale, const Color& color);
     Point getTilePoint(const Position& pos, const Rect& screenRect, const Position& mapCenter, float scale);
@@ -95,6 +104,8 @@ public:
     void updateTile(const Position& pos, const TilePtr& tile);
     const MinimapTile& getTile(const Position& pos);
     std::pair<MinimapBlock_ptr, MinimapTile> threadGetTile(const Position& pos);
+    uint32_t threadGetBlockVersion(const Position& pos);
+    uint32_t threadGetBlockTiles(const Position& pos, std::array<MinimapTile, MMBLOCK_SIZE* MMBLOCK_SIZE>& tiles);
 
     bool loadImage(const std::string& fileName, const Position& topLeft, float colorFactor);
     void saveImage(const std::string& fileName, const Rect& mapRect);
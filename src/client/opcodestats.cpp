@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "opcodestats.h"
+#include <framework/net/inputmessage.h>
+
+#include <bit>
+
+OpcodeStats g_opcodeStats;
+
+void OpcodeStats::record(uint8_t opcode, uint32_t bytes, ticks_t micros)
+{
+    const auto elapsed = static_cast<uint32_t>(std::max<ticks_t>(micros, 0));
+
+    Entry& entry = m_entries[opcode];
+    ++entry.count;
+    entry.bytes += bytes;
+    entry.totalMicros += elapsed;
+    entry.maxMicros = std::max(entry.maxMicros, elapsed);
+    ++entry.histogram[std::min<int>(std::bit_width(elapsed), HISTOGRAM_BUCKETS) - (elapsed > 0)];
+}
+
+void OpcodeStats::recordMessage(const InputMessagePtr& msg, uint32_t opcodes, ticks_t micros, int slowestOpcode, ticks_t slowestMicros)
+{
+    if (m_slowThreshold <= 0 || micros < m_slowThreshold)
+        return;
+
+    g_logger.warning(stdext::format("Slow game message: %u opcodes, %d bytes parsed in %.2f ms, slowest opcode 0x%02X took %.2f ms",
+                                    opcodes, static_cast<int>(msg->getMessageSize()), micros / 1000.0, slowestOpcode, slowestMicros / 1000.0));
+}
+
+void OpcodeStats::reset()
+{
+    m_entries.fill({});
+}
+
+uint32_t OpcodeStats::getPercentile(const Entry& entry, double percentile)
+{
+    if (entry.count == 0)
+        return 0;
+
+    // the upper bound of the bucket holding the percentile, never above the real max
+    const auto rank = static_cast<uint64_t>(std::ceil(entry.count * percentile));
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        seen += entry.histogram[i];
+        if (seen >= rank)
+            return std::min<uint32_t>((2u << i) - 1, entry.maxMicros);
+    }
+    return entry.maxMicros;
+}
+
+std::map<std::string, double> OpcodeStats::getStats(uint8_t opcode)
+{
+    const Entry& entry = m_entries[opcode];
+    return {
+        { "count", static_cast<double>(entry.count) },
+        { "bytes", static_cast<double>(entry.bytes) },
+        { "total", static_cast<double>(entry.totalMicros) },
+        { "average", entry.count > 0 ? static_cast<double>(entry.totalMicros) / entry.count : 0 },
+        { "p50", getPercentile(entry, 0.5) },
+        { "p99", getPercentile(entry, 0.99) },
+        { "max", entry.maxMicros }
+    };
+}
+
+std::vector<uint8_t> OpcodeStats::getRecordedOpcodes()
+{
+    std::vector<uint8_t> opcodes;
+    for (int opcode = 0; opcode < 256; ++opcode) {
+        if (m_entries[opcode].count > 0)
+            opcodes.emplace_back(opcode);
+    }
+    return opcodes;
+}
+
+std::string OpcodeStats::dump(int limit)
+{
+    auto opcodes = getRecordedOpcodes();
+    std::sort(opcodes.begin(), opcodes.end(), [this](uint8_t a, uint8_t b) {
+        return m_entries[a].totalMicros > m_entries[b].totalMicros;
+    });
+    if (limit > 0 && opcodes.size() > static_cast<size_t>(limit))
+        opcodes.resize(limit);
+
+    std::string ret = "opcode      count        bytes   total(ms)   avg(us)   p50(us)   p99(us)   max(us)\n";
+    for (const uint8_t opcode : opcodes) {
+        const Entry& entry = m_entries[opcode];
+        ret += stdext::format("0x%02X %12llu %12llu %11.2f %9.1f %9u %9u %9u\n", static_cast<int>(opcode),
+                              static_cast<unsigned long long>(entry.count), static_cast<unsigned long long>(entry.bytes),
+                              entry.totalMicros / 1000.0, static_cast<double>(entry.totalMicros) / entry.count,
+                              getPercentile(entry, 0.5), getPercentile(entry, 0.99), entry.maxMicros);
+    }
+    return ret;
+}
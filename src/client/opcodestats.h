@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "declarations.h"
+
+// parse cost of every server opcode, fed by ProtocolGame::parseMessage
+class OpcodeStats
+{
+public:
+    // bucket i holds parse times in [2^i, 2^(i+1)) microseconds
+    static constexpr int HISTOGRAM_BUCKETS = 25;
+
+    struct Entry
+    {
+        uint64_t count{ 0 };
+        uint64_t bytes{ 0 };
+        uint64_t totalMicros{ 0 };
+        uint32_t maxMicros{ 0 };
+        std::array<uint32_t, HISTOGRAM_BUCKETS> histogram{};
+    };
+
+    void record(uint8_t opcode, uint32_t bytes, ticks_t micros);
+    void recordMessage(const InputMessagePtr& msg, uint32_t opcodes, ticks_t micros, int slowestOpcode, ticks_t slowestMicros);
+    void reset();
+
+    // off by default, measuring reads the clock around every opcode
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() { return m_enabled; }
+
+    // messages that take longer than this to parse are logged, 0 disables it
+    void setSlowThreshold(int millis) { m_slowThreshold = millis * 1000; }
+    int getSlowThreshold() { return m_slowThreshold / 1000; }
+
+    // count, bytes, total, average, p50, p99 and max, times in microseconds
+    std::map<std::string, double> getStats(uint8_t opcode);
+    std::vector<uint8_t> getRecordedOpcodes();
+
+    // text table of the opcodes with the highest total parse time
+    std::string dump(int limit);
+
+private:
+    uint32_t getPercentile(const Entry& entry, double percentile);
+
+    std::array<Entry, 256> m_entries{};
+    bool m_enabled{ false };
+    ticks_t m_slowThreshold{ 0 };
+};
+
+extern OpcodeStats g_opcodeStats;
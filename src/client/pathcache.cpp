@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "pathcache.h"
+#include "map.h"
+
+size_t PathCache::KeyHasher::operator()(const Key& key) const
+{
+    size_t hash = Position::Hasher()(key.start);
+    stdext::hash_combine(hash, Position::Hasher()(key.goal));
+    stdext::hash_combine(hash, key.flags);
+    return hash;
+}
+
+const PathCache::Result* PathCache::get(const Position& start, const Position& goal, int flags)
+{
+    if (!m_enabled)
+        return nullptr;
+
+    const auto it = m_index.find({ start, goal, flags });
+    if (it == m_index.end()) {
+        ++m_misses;
+        return nullptr;
+    }
+
+    if (!isValid(*it->second)) {
+        m_entries.erase(it->second);
+        m_index.erase(it);
+        ++m_invalidated;
+        ++m_misses;
+        return nullptr;
+    }
+
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    ++m_hits;
+    return &m_entries.front().result;
+}
+
+void PathCache::put(const Position& start, const Position& goal, int flags, const Result& result)
+{
+    if (!m_enabled || start.z > MAX_Z)
+        return;
+
+    const Key key{ start, goal, flags };
+    if (const auto it = m_index.find(key); it != m_index.end()) {
+        m_entries.erase(it->second);
+        m_index.erase(it);
+    }
+
+    Entry entry{ key, result, g_map.getFloorVersion(start.z), {} };
+
+    // regions are told apart by their versions, so the first position seen in each is kept
+    Position pos = start;
+    const auto addRegion = [&](const Position& regionPos) {
+        const uint64_t version = g_map.getRegionVersion(regionPos);
+        const bool known = std::any_of(entry.regions.begin(), entry.regions.end(), [&](const auto& region) {
+            return g_map.isSameRegion(region.first, regionPos);
+        });
+        if (!known)
+            entry.regions.emplace_back(regionPos, version);
+    };
+
+    addRegion(pos);
+    for (const Otc::Direction dir : result.path) {
+        pos = pos.translatedToDirection(dir);
+        addRegion(pos);
+    }
+
+    m_entries.push_front(std::move(entry));
+    m_index[key] = m_entries.begin();
+
+    if (m_entries.size() > MAX_ENTRIES) {
+        m_index.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+}
+
+void PathCache::clear()
+{
+    m_entries.clear();
+    m_index.clear();
+}
+
+void PathCache::setEnabled(bool enable)
+{
+    m_enabled = enable;
+    if (!enable)
+        clear();
+}
+
+bool PathCache::isValid(const Entry& entry) const
+{
+    if (entry.result.status != Otc::PathFindResultOk)
+        return entry.floorVersion == g_map.getFloorVersion(entry.key.start.z);
+
+    return std::all_of(entry.regions.begin(), entry.regions.end(), [](const auto& region) {
+        return g_map.getRegionVersion(region.first) == region.second;
+    });
+}
+
+std::map<std::string, double> PathCache::getStats() const
+{
+    return {
+        { "entries", static_cast<double>(m_entries.size()) },
+        { "hits", m_hits },
+        { "misses", m_misses },
+        { "invalidated", m_invalidated },
+        { "hitRate", m_hits + m_misses > 0 ? m_hits / static_cast<double>(m_hits + m_misses) : 0 }
+    };
+}
+
+void PathCache::resetStats()
+{
+    m_hits = 0;
+    m_misses = 0;
+    m_invalidated = 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "declarations.h"
+#include "position.h"
+
+// recently found paths by start, goal and flags; a path stays valid while none of the regions
+// it walks through changed and a failed search while nothing changed on its floor
+class PathCache
+{
+public:
+    // flags of Map::newFindPath results, which take no flags of their own
+    static constexpr int ASYNC_SEARCH = -1;
+
+    struct Result
+    {
+        Otc::PathFindResult status;
+        std::vector<Otc::Direction> path;
+        int complexity;
+    };
+
+    const Result* get(const Position& start, const Position& goal, int flags);
+    void put(const Position& start, const Position& goal, int flags, const Result& result);
+    void clear();
+
+    void setEnabled(bool enable);
+    bool isEnabled() const { return m_enabled; }
+
+    std::map<std::string, double> getStats() const;
+    void resetStats();
+
+private:
+    enum { MAX_ENTRIES = 256 };
+
+    struct Key
+    {
+        Position start;
+        Position goal;
+        int flags;
+
+        bool operator==(const Key& other) const { return start == other.start && goal == other.goal && flags == other.flags; }
+    };
+
+    struct KeyHasher
+    {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        Result result;
+        uint32_t floorVersion;
+        std::vector<std::pair<Position, uint64_t>> regions; // a position of every region crossed and its version
+    };
+
+    bool isValid(const Entry& entry) const;
+
+    // most recently used first
+    std::list<Entry> m_entries;
+    stdext::map<Key, std::list<Entry>::iterator, KeyHasher> m_index;
+
+    bool m_enabled{ true };
+    uint32_t m_hits{ 0 };
+    uint32_t m_misses{ 0 };
+    uint32_t m_invalidated{ 0 };
+};
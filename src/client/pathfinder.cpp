@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "pathfinder.h"
+#include "map.h"
+#include "minimap.h"
+#include "tile.h"
+
+namespace
+{
+    constexpr Otc::Direction directions[3][3] = {
+        { Otc::NorthWest, Otc::West, Otc::SouthWest },
+        { Otc::North, Otc::InvalidDirection, Otc::South },
+        { Otc::NorthEast, Otc::East, Otc::SouthEast }
+    };
+}
+
+std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult> PathFinder::find(const Position& start, const Position& goal, int maxComplexity, int flags)
+{
+    std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult> ret;
+    std::vector<Otc::Direction>& dirs = std::get<0>(ret);
+    Otc::PathFindResult& result = std::get<1>(ret);
+
+    result = Otc::PathFindResultNoWay;
+    m_nodes.clear();
+
+    if (start == goal) {
+        result = Otc::PathFindResultSamePosition;
+        return ret;
+    }
+
+    if (start.z != goal.z) {
+        result = Otc::PathFindResultImpossible;
+        return ret;
+    }
+
+    // check the goal pos is walkable
+    if (g_map.isAwareOfPosition(goal)) {
+        const TilePtr& goalTile = g_map.getTile(goal);
+        if (!goalTile || !goalTile->isWalkable(flags & Otc::PathFindIgnoreCreatures))
+            return ret;
+    } else if (g_minimap.getTile(goal).hasFlag(MinimapTileNotWalkable))
+        return ret;
+
+    reset(start, goal, flags);
+
+    m_nodes.push_back({ 0, 0, start, NO_NODE, NO_NODE, 0, Otc::InvalidDirection });
+    getCell(start).node = 0;
+
+    uint32_t current = 0;
+    uint32_t found = NO_NODE;
+    while (current != NO_NODE) {
+        if (static_cast<int>(m_nodes.size()) > maxComplexity) {
+            result = Otc::PathFindResultTooFar;
+            break;
+        }
+
+        const Node& node = m_nodes[current];
+
+        // path found
+        if (node.pos == goal && (found == NO_NODE || node.cost < m_nodes[found].cost))
+            found = current;
+
+        // cost too high
+        if (found != NO_NODE && node.totalCost >= m_nodes[found].cost)
+            break;
+
+        expand(current);
+        current = m_heap.empty() ? NO_NODE : heapPop();
+    }
+
+    if (found != NO_NODE) {
+        for (uint32_t index = found; m_nodes[index].prev != NO_NODE; index = m_nodes[index].prev)
+            dirs.insert(dirs.end(), m_nodes[index].steps, m_nodes[index].dir);
+        std::reverse(dirs.begin(), dirs.end());
+        result = Otc::PathFindResultOk;
+    }
+
+    return ret;
+}
+
+float PathFinder::getPathCost(const Position& start, const std::vector<Otc::Direction>& dirs, int flags)
+{
+    Position pos = start;
+    for (const Otc::Direction dir : dirs)
+        pos = pos.translatedToDirection(dir);
+
+    reset(start, pos, flags);
+
+    float cost = 0;
+    pos = start;
+    for (const Otc::Direction dir : dirs) {
+        pos = pos.translatedToDirection(dir);
+        cost += (std::max<int16_t>(getSpeed(pos), 0) * (dir >= Otc::NorthEast ? 3.0f : 1.0f)) / 100.0f;
+    }
+
+    return cost;
+}
+
+void PathFinder::reset(const Position& start, const Position& goal, int flags)
+{
+    m_goal = goal;
+    m_flags = flags;
+    m_heap.clear();
+    m_outsideCells.clear();
+
+    // cells are recycled by bumping the generation instead of clearing the window
+    if (++m_generation == 0) {
+        std::fill(m_window.begin(), m_window.end(), Cell());
+        m_generation = 1;
+    }
+
+    m_windowWidth = std::min<int32_t>(std::abs(goal.x - start.x) + 2 * WINDOW_MARGIN, MAX_WINDOW_SIZE);
+    m_windowHeight = std::min<int32_t>(std::abs(goal.y - start.y) + 2 * WINDOW_MARGIN, MAX_WINDOW_SIZE);
+    m_windowX = std::min<int32_t>(start.x, goal.x) - WINDOW_MARGIN;
+    m_windowY = std::min<int32_t>(start.y, goal.y) - WINDOW_MARGIN;
+
+    // when the route doesn't fit, keep the window around the start
+    if (std::abs(goal.x - start.x) + 2 * WINDOW_MARGIN > MAX_WINDOW_SIZE)
+        m_windowX = start.x - m_windowWidth / 2;
+    if (std::abs(goal.y - start.y) + 2 * WINDOW_MARGIN > MAX_WINDOW_SIZE)
+        m_windowY = start.y - m_windowHeight / 2;
+
+    const size_t size = static_cast<size_t>(m_windowWidth) * m_windowHeight;
+    if (m_window.size() < size)
+        m_window.resize(size);
+}
+
+PathFinder::Cell& PathFinder::getCell(const Position& pos)
+{
+    const int32_t x = pos.x - m_windowX;
+    const int32_t y = pos.y - m_windowY;
+    if (static_cast<uint32_t>(x) >= static_cast<uint32_t>(m_windowWidth) || static_cast<uint32_t>(y) >= static_cast<uint32_t>(m_windowHeight))
+        return m_outsideCells[pos];
+
+    Cell& cell = m_window[y * m_windowWidth + x];
+    if (cell.generation != m_generation)
+        cell = { m_generation, NO_NODE, UNKNOWN };
+
+    return cell;
+}
+
+int16_t PathFinder::getSpeed(const Position& pos)
+{
+    Cell& cell = getCell(pos);
+    if (cell.speed == UNKNOWN)
+        cell.speed = computeSpeed(pos);
+
+    return cell.speed;
+}
+
+int16_t PathFinder::computeSpeed(const Position& pos)
+{
+    bool wasSeen = false;
+    bool hasCreature = false;
+    bool isNotWalkable = true;
+    bool isNotPathable = true;
+    int speed = 100;
+
+    if (g_map.isAwareOfPosition(pos)) {
+        wasSeen = true;
+        if (const TilePtr& tile = g_map.getTile(pos)) {
+            hasCreature = tile->hasCreature() && !(m_flags & Otc::PathFindIgnoreCreatures);
+            isNotWalkable = !tile->isWalkable(m_flags & Otc::PathFindIgnoreCreatures);
+            isNotPathable = !tile->isPathable();
+            speed = tile->getGroundSpeed();
+        }
+    } else {
+        const MinimapTile& mtile = g_minimap.getTile(pos);
+        wasSeen = mtile.hasFlag(MinimapTileWasSeen);
+        isNotWalkable = mtile.hasFlag(MinimapTileNotWalkable);
+        isNotPathable = mtile.hasFlag(MinimapTileNotPathable);
+        if (isNotWalkable || isNotPathable)
+            wasSeen = true;
+        speed = mtile.getSpeed();
+    }
+
+    if (!(m_flags & Otc::PathFindAllowNotSeenTiles) && !wasSeen)
+        return BLOCKED;
+
+    if (wasSeen) {
+        if (pos != m_goal) {
+            if (!(m_flags & Otc::PathFindAllowCreatures) && hasCreature)
+                return BLOCKED;
+            if (!(m_flags & Otc::PathFindAllowNonPathable) && isNotPathable)
+                return BLOCKED;
+        }
+        if (!(m_flags & Otc::PathFindAllowNonWalkable) && isNotWalkable)
+            return BLOCKED;
+    }
+
+    return static_cast<int16_t>(std::clamp<int>(speed, 0, INT16_MAX));
+}
+
+void PathFinder::expand(uint32_t index)
+{
+    const Position pos = m_nodes[index].pos;
+    const float cost = m_nodes[index].cost;
+    const bool jumpPoints = m_flags & Otc::PathFindJumpPoints;
+
+    for (int i = -1; i <= 1; ++i) {
+        for (int j = -1; j <= 1; ++j) {
+            if (i == 0 && j == 0)
+                continue;
+
+            const Position neighborPos = pos.translated(i, j);
+            if (neighborPos.x < 0 || neighborPos.y < 0)
+                continue;
+
+            const Otc::Direction dir = directions[i + 1][j + 1];
+            if (jumpPoints && (i == 0 || j == 0)) {
+                Position jumpPos = pos;
+                float jumpCost = cost;
+                uint16_t steps = 0;
+                if (jump(jumpPos, jumpCost, steps, i, j))
+                    open(jumpPos, jumpCost, index, dir, steps);
+                continue;
+            }
+
+            const int16_t speed = getSpeed(neighborPos);
+            if (speed == BLOCKED)
+                continue;
+
+            const float walkFactor = dir >= Otc::NorthEast ? 3.0f : 1.0f;
+            open(neighborPos, cost + (speed * walkFactor) / 100.0f, index, dir, 1);
+        }
+    }
+}
+
+void PathFinder::open(const Position& pos, float cost, uint32_t prev, Otc::Direction dir, uint16_t steps)
+{
+    uint32_t index = getCell(pos).node;
+    if (index == NO_NODE) {
+        index = m_nodes.size();
+        m_nodes.push_back({ 0, 0, pos, NO_NODE, NO_NODE, 0, Otc::InvalidDirection });
+        getCell(pos).node = index;
+    } else if (m_nodes[index].cost <= cost)
+        return;
+
+    Node& node = m_nodes[index];
+    node.prev = prev;
+    node.cost = cost;
+    node.totalCost = node.cost + pos.distance(m_goal);
+    node.dir = dir;
+    node.steps = steps;
+
+    if (node.heapIndex == NO_NODE)
+        heapPush(index);
+    else
+        heapSiftUp(node.heapIndex);
+}
+
+// moves straight from pos until a cell where the search may have to branch: the goal, a change
+// of ground speed or a forced neighbor; paths are taken as horizontal moves first, so every
+// cell of a horizontal jump also scans up and down and stops when one of the scans finds a cell
+bool PathFinder::jump(Position& pos, float& cost, uint16_t& steps, int dx, int dy)
+{
+    int16_t lineSpeed = UNKNOWN;
+    while (true) {
+        pos = pos.translated(dx, dy);
+        if (pos.x < 0 || pos.y < 0)
+            return false;
+
+        const int16_t speed = getSpeed(pos);
+        if (speed == BLOCKED)
+            return false;
+
+        cost += speed / 100.0f;
+        ++steps;
+
+        if (lineSpeed == UNKNOWN)
+            lineSpeed = speed;
+
+        if (pos == m_goal || speed != lineSpeed || steps >= MAX_JUMP_LENGTH || hasForcedNeighbor(pos, dx, dy, lineSpeed))
+            return true;
+
+        if (dy == 0) {
+            for (const int scanDy : { -1, 1 }) {
+                Position scanPos = pos;
+                float scanCost = 0;
+                uint16_t scanSteps = 0;
+                if (jump(scanPos, scanCost, scanSteps, 0, scanDy))
+                    return true;
+            }
+        }
+    }
+}
+
+bool PathFinder::hasForcedNeighbor(const Position& pos, int dx, int dy, int16_t lineSpeed)
+{
+    const int16_t forwardSpeed = getSpeed(pos.translated(dx, dy));
+    for (const int side : { -1, 1 }) {
+        const int sideX = dy * side, sideY = dx * side;
+        const int16_t sideSpeed = getSpeed(pos.translated(sideX, sideY));
+
+        // a vertical move that turns here can be turned one cell earlier for the same cost,
+        // unless the cell beside the previous one is different ground
+        if (dx == 0 && sideSpeed != BLOCKED && getSpeed(pos.translated(sideX, sideY - dy)) != lineSpeed)
+            return true;
+
+        // diagonals cost three straight moves, cutting the corner only pays off
+        // when neither cell around it is a cheap enough detour
+        const int16_t diagonalSpeed = getSpeed(pos.translated(dx + sideX, dy + sideY));
+        if (diagonalSpeed != BLOCKED) {
+            const bool viaForward = forwardSpeed != BLOCKED && forwardSpeed <= 2 * diagonalSpeed;
+            const bool viaSide = sideSpeed != BLOCKED && sideSpeed <= 2 * diagonalSpeed;
+            if (!viaForward && !viaSide)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+bool PathFinder::heapLess(uint32_t a, uint32_t b) const
+{
+    return m_nodes[a].totalCost < m_nodes[b].totalCost;
+}
+
+void PathFinder::heapPush(uint32_t index)
+{
+    m_nodes[index].heapIndex = m_heap.size();
+    m_heap.push_back(index);
+    heapSiftUp(m_heap.size() - 1);
+}
+
+uint32_t PathFinder::heapPop()
+{
+    const uint32_t top = m_heap.front();
+    m_nodes[top].heapIndex = NO_NODE;
+
+    m_heap.front() = m_heap.back();
+    m_heap.pop_back();
+    if (!m_heap.empty()) {
+        m_nodes[m_heap.front()].heapIndex = 0;
+        heapSiftDown(0);
+    }
+
+    return top;
+}
+
+void PathFinder::heapSiftUp(uint32_t heapIndex)
+{
+    const uint32_t index = m_heap[heapIndex];
+    while (heapIndex > 0) {
+        const uint32_t parent = (heapIndex - 1) / 2;
+        if (!heapLess(index, m_heap[parent]))
+            break;
+
+        m_heap[heapIndex] = m_heap[parent];
+        m_nodes[m_heap[heapIndex]].heapIndex = heapIndex;
+        heapIndex = parent;
+    }
+
+    m_heap[heapIndex] = index;
+    m_nodes[index].heapIndex = heapIndex;
+}
+
+void PathFinder::heapSiftDown(uint32_t heapIndex)
+{
+    const uint32_t index = m_heap[heapIndex];
+    const uint32_t size = m_heap.size();
+    while (true) {
+        uint32_t child = heapIndex * 2 + 1;
+        if (child >= size)
+            break;
+
+        if (child + 1 < size && heapLess(m_heap[child + 1], m_heap[child]))
+            ++child;
+
+        if (!heapLess(m_heap[child], index))
+            break;
+
+        m_heap[heapIndex] = m_heap[child];
+        m_nodes[m_heap[heapIndex]].heapIndex = heapIndex;
+        heapIndex = child;
+    }
+
+    m_heap[heapIndex] = index;
+    m_nodes[index].heapIndex = heapIndex;
+}
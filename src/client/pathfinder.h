@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "declarations.h"
+#include "position.h"
+
+#include <unordered_map>
+
+// grid search behind Map::findPath, nodes come from an arena that is reset on every query,
+// positions around the route map to a dense window instead of a hash map and the open list
+// is an indexed binary heap, so improving a node updates its entry instead of pushing another
+class PathFinder
+{
+public:
+    std::tuple<std::vector<Otc::Direction>, Otc::PathFindResult> find(const Position& start, const Position& goal, int maxComplexity, int flags);
+
+    // cost of walking dirs from start, as the search would count it
+    float getPathCost(const Position& start, const std::vector<Otc::Direction>& dirs, int flags);
+
+    uint32_t getLastComplexity() const { return m_nodes.size(); }
+
+private:
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+    static constexpr int16_t BLOCKED = -1;
+    static constexpr int16_t UNKNOWN = -2;
+
+    enum
+    {
+        WINDOW_MARGIN = 64,
+        MAX_WINDOW_SIZE = 512,
+        MAX_JUMP_LENGTH = 64
+    };
+
+    struct Node
+    {
+        float cost;
+        float totalCost;
+        Position pos;
+        uint32_t prev;
+        uint32_t heapIndex;
+        uint16_t steps; // straight steps of the jump that reached the node, one for plain moves
+        Otc::Direction dir;
+    };
+
+    struct Cell
+    {
+        uint32_t generation{ 0 };
+        uint32_t node{ NO_NODE };
+        int16_t speed{ UNKNOWN };
+    };
+
+    void reset(const Position& start, const Position& goal, int flags);
+    Cell& getCell(const Position& pos);
+    int16_t getSpeed(const Position& pos);
+    int16_t computeSpeed(const Position& pos);
+
+    void expand(uint32_t index);
+    void open(const Position& pos, float cost, uint32_t prev, Otc::Direction dir, uint16_t steps);
+
+    bool jump(Position& pos, float& cost, uint16_t& steps, int dx, int dy);
+    bool hasForcedNeighbor(const Position& pos, int dx, int dy, int16_t lineSpeed);
+
+    void heapPush(uint32_t index);
+    uint32_t heapPop();
+    void heapSiftUp(uint32_t heapIndex);
+    void heapSiftDown(uint32_t heapIndex);
+    bool heapLess(uint32_t a, uint32_t b) const;
+
+    // bump arena, cleared but never shrunk between queries
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_heap;
+
+    // window around the route plus a fallback for positions outside of it
+    std::vector<Cell> m_window;
+    std::unordered_map<Position, Cell, Position::Hasher> m_outsideCells;
+    int32_t m_windowX{ 0 };
+    int32_t m_windowY{ 0 };
+    int32_t m_windowWidth{ 0 };
+    int32_t m_windowHeight{ 0 };
+    uint32_t m_generation{ 0 };
+
+    Position m_goal;
+    int m_flags{ 0 };
+};
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "pathfindservice.h"
+#include "map.h"
+#include "tile.h"
+
+#include <framework/core/eventdispatcher.h>
+
+const WalkSnapshot::Entry* WalkSnapshot::getEntry(const Position& pos) const
+{
+    const int32_t x = pos.x - m_origin.x;
+    const int32_t y = pos.y - m_origin.y;
+    if (pos.z != m_origin.z || static_cast<uint32_t>(x) >= static_cast<uint32_t>(m_width) || static_cast<uint32_t>(y) >= static_cast<uint32_t>(m_height))
+        return nullptr;
+
+    return &m_entries[y * m_width + x];
+}
+
+void PathFindService::init()
+{
+    m_running = true;
+
+    const uint32_t workers = std::clamp<uint32_t>(std::thread::hardware_concurrency() / 2, 1, MAX_WORKERS);
+    for (uint32_t i = 0; i < workers; ++i)
+        m_workers.emplace_back([this] { workerLoop(); });
+}
+
+void PathFindService::terminate()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_running = false;
+        for (const Task& task : m_tasks)
+            task.request->cancel();
+        m_tasks.clear();
+    }
+
+    m_condition.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+
+    for (auto& snapshot : m_snapshots)
+        snapshot.reset();
+}
+
+PathFindRequestPtr PathFindService::find(const Position& start, const Position& goal, const std::function<void(PathFindResult_ptr)>& callback)
+{
+    const auto request = std::make_shared<PathFindRequest>();
+    ++m_stats.requests;
+
+    Task task{ request, start, goal, start.z <= MAX_Z ? getSnapshot(start.z) : nullptr, callback, stdext::micros() };
+    {
+        std::lock_guard lock(m_mutex);
+        m_tasks.emplace_back(std::move(task));
+    }
+    m_condition.notify_one();
+
+    return request;
+}
+
+WalkSnapshotPtr PathFindService::getSnapshot(uint8_t z)
+{
+    // the aware area of a floor is shifted by one tile for each floor away from the camera
+    const Position central = g_map.getCentralPosition();
+    AwareRange range = g_map.getAwareRange();
+    const int32_t offset = central.z - z;
+    const Position origin(central.x - range.left + offset, central.y - range.top + offset, z);
+
+    auto& snapshot = m_snapshots[z];
+    if (snapshot && snapshot->m_version == g_map.getFloorVersion(z) && snapshot->m_origin == origin && snapshot->m_width == range.horizontal() && snapshot->m_height == range.vertical())
+        return snapshot;
+
+    // a snapshot still held by a worker is left alone, otherwise its memory is reused
+    if (!snapshot || snapshot.use_count() > 1)
+        snapshot = std::make_shared<WalkSnapshot>();
+
+    snapshot->m_origin = origin;
+    snapshot->m_version = g_map.getFloorVersion(z);
+    snapshot->m_width = range.horizontal();
+    snapshot->m_height = range.vertical();
+    snapshot->m_entries.assign(static_cast<size_t>(snapshot->m_width) * snapshot->m_height, {});
+
+    for (int32_t y = 0; y < snapshot->m_height; ++y) {
+        for (int32_t x = 0; x < snapshot->m_width; ++x) {
+            const TilePtr& tile = g_map.getTile(origin.translated(x, y));
+            if (!tile)
+                continue;
+
+            auto& entry = snapshot->m_entries[y * snapshot->m_width + x];
+            entry.speed = tile->getGroundSpeed();
+            entry.flags = WalkSnapshot::EntryHasTile;
+            if (tile->isWalkable(false))
+                entry.flags |= WalkSnapshot::EntryWalkable;
+            if (tile->isPathable())
+                entry.flags |= WalkSnapshot::EntryPathable;
+        }
+    }
+
+    return snapshot;
+}
+
+void PathFindService::workerLoop()
+{
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        m_condition.wait(lock, [this] { return !m_tasks.empty() || !m_running; });
+        if (!m_running)
+            return;
+
+        Task task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+
+        lock.unlock();
+        execute(task);
+        lock.lock();
+    }
+}
+
+void PathFindService::execute(Task& task)
+{
+    if (task.request->isCanceled()) {
+        ++m_canceled;
+        return;
+    }
+
+    const ticks_t startedAt = stdext::micros();
+    const auto result = g_map.newFindPath(task.start, task.goal, task.snapshot, task.request);
+    if (task.request->isCanceled()) {
+        ++m_canceled;
+        return;
+    }
+
+    result->queueTime = (startedAt - task.queuedAt) / 1000.f;
+    result->searchTime = (stdext::micros() - startedAt) / 1000.f;
+
+    g_dispatcher.addEvent([this, request = task.request, callback = task.callback, queuedAt = task.queuedAt, result] {
+        if (request->isCanceled()) {
+            ++m_canceled;
+            return;
+        }
+
+        result->totalTime = (stdext::micros() - queuedAt) / 1000.f;
+
+        ++m_stats.completed;
+        m_stats.queueTime += result->queueTime;
+        m_stats.searchTime += result->searchTime;
+        m_stats.totalTime += result->totalTime;
+        m_stats.maxTotalTime = std::max<double>(m_stats.maxTotalTime, result->totalTime);
+
+        callback(result);
+    });
+}
+
+std::map<std::string, double> PathFindService::getStats()
+{
+    size_t pending;
+    {
+        std::lock_guard lock(m_mutex);
+        pending = m_tasks.size();
+    }
+
+    const double completed = std::max<uint32_t>(m_stats.completed, 1);
+    return {
+        { "workers", static_cast<double>(m_workers.size()) },
+        { "requests", m_stats.requests },
+        { "completed", m_stats.completed },
+        { "canceled", m_canceled },
+        { "pending", static_cast<double>(pending) },
+        { "avgQueueTime", m_stats.queueTime / completed },
+        { "avgSearchTime", m_stats.searchTime / completed },
+        { "avgTotalTime", m_stats.totalTime / completed },
+        { "maxTotalTime", m_stats.maxTotalTime }
+    };
+}
+
+void PathFindService::resetStats()
+{
+    m_stats = {};
+    m_canceled = 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "declarations.h"
+#include "position.h"
+
+#include <condition_variable>
+#include <thread>
+
+struct PathFindResult
+{
+    Otc::PathFindResult status = Otc::PathFindResultNoWay;
+    std::vector<Otc::Direction> path;
+    int complexity = 0;
+    Position start;
+    Position destination;
+
+    // milliseconds spent waiting for a worker, searching and until the result was delivered
+    float queueTime = 0;
+    float searchTime = 0;
+    float totalTime = 0;
+};
+using PathFindResult_ptr = std::shared_ptr<PathFindResult>;
+
+// walkability of a floor inside the aware area, built on the main thread and only read by the
+// workers; map changes never touch a snapshot in use, the next request on a floor whose version
+// moved on gets a new one instead
+class WalkSnapshot
+{
+public:
+    enum EntryFlags : uint8_t
+    {
+        EntryHasTile = 1,
+        EntryWalkable = 2,
+        EntryPathable = 4
+    };
+
+    struct Entry
+    {
+        uint16_t speed{ 0 };
+        uint8_t flags{ 0 };
+
+        bool hasFlag(EntryFlags flag) const { return flags & flag; }
+    };
+
+    // nullptr outside of the aware area
+    const Entry* getEntry(const Position& pos) const;
+
+private:
+    Position m_origin;
+    uint32_t m_version{ 0 };
+    int32_t m_width{ 0 };
+    int32_t m_height{ 0 };
+    std::vector<Entry> m_entries;
+
+    friend class PathFindService;
+};
+using WalkSnapshotPtr = std::shared_ptr<const WalkSnapshot>;
+
+class PathFindRequest
+{
+public:
+    void cancel() { m_canceled = true; }
+    bool isCanceled() const { return m_canceled; }
+
+private:
+    std::atomic<bool> m_canceled{ false };
+};
+
+// runs Map::newFindPath on its own workers, results are delivered on the main thread
+// unless the request was canceled before
+class PathFindService
+{
+public:
+    void init();
+    void terminate();
+
+    PathFindRequestPtr find(const Position& start, const Position& goal, const std::function<void(PathFindResult_ptr)>& callback);
+
+    std::map<std::string, double> getStats();
+    void resetStats();
+
+private:
+    enum { MAX_WORKERS = 4 };
+
+    struct Task
+    {
+        PathFindRequestPtr request;
+        Position start;
+        Position goal;
+        WalkSnapshotPtr snapshot;
+        std::function<void(PathFindResult_ptr)> callback;
+        ticks_t queuedAt;
+    };
+
+    struct Stats
+    {
+        uint32_t requests{ 0 };
+        uint32_t completed{ 0 };
+        double queueTime{ 0 };
+        double searchTime{ 0 };
+        double totalTime{ 0 };
+        double maxTotalTime{ 0 };
+    };
+
+    WalkSnapshotPtr getSnapshot(uint8_t z);
+    void workerLoop();
+    void execute(Task& task);
+
+    std::vector<std::thread> m_workers;
+    std::deque<Task> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_running{ false };
+
+    std::shared_ptr<WalkSnapshot> m_snapshots[MAX_Z + 1];
+
+    Stats m_stats;
+    std::atomic<uint32_t> m_canceled{ 0 };
+};
@@ -24,6 +24,8 @@
 #include "framework/net/inputmessage.h"
 #include "game.h"
 
+std::bitset<256> ProtocolGame::m_hookedOpcodes;
+
 void ProtocolGame::login(const std::string_view accountName, const std::string_view accountPassword, const std::string_view host, uint16_t port,
                          const std::string_view characterName, const std::string_view authenticatorToken, const std::string_view sessionKey)
 {
@@ -36,16 +38,33 @@ void ProtocolGame::login(const std::string_view accountName, const std::string_v
     connect(host, port);
 }
 
+void ProtocolGame::startReplay()
+{
+    // the recorded messages are already decrypted, only the size check of the first one is left
+    m_firstRecv = true;
+    m_localPlayer = g_game.getLocalPlayer();
+}
+
 void ProtocolGame::onConnect()
 {
     m_firstRecv = true;
     Protocol::onConnect();
 
-    m_localPlayer = g_game.getLocalPlayer();
+    if (!m_headless)
+        m_localPlayer = g_game.getLocalPlayer();
 
     if (g_game.getFeature(Otc::GameProtocolChecksum))
         enableChecksum();
 
+    if (g_game.getFeature(Otc::GamePacketCompression)) {
+        enableCompression();
+        setOutboundCompression(g_game.getFeature(Otc::GamePacketCompressionOutbound));
+    }
+
+    // map bursts come as many small packets, read them in batches, opt-in until it has seen more servers
+    if (g_game.getFeature(Otc::GameCoalescedRecv))
+        enableCoalescedRecv();
+
     if (!g_game.getFeature(Otc::GameChallengeOnLogin))
         sendLoginPacket(0, 0);
 
@@ -66,12 +85,20 @@ void ProtocolGame::onRecv(const InputMessagePtr& inputMessage)
         }
     }
 
-    parseMessage(inputMessage);
+    if (m_headless)
+        parseHeadlessMessage(inputMessage);
+    else
+        parseMessage(inputMessage);
     recv();
 }
 
 void ProtocolGame::onError(const std::error_code& error)
 {
+    if (m_headless) {
+        Protocol::onError(error);
+        return;
+    }
+
     g_game.processConnectionError(error);
     disconnect();
 }
@@ -26,11 +26,21 @@
 #include "declarations.h"
 #include "protocolcodes.h"
 #include <framework/net/protocol.h>
+#include <bitset>
 
 class ProtocolGame : public Protocol
 {
 public:
     void login(const std::string_view accountName, const std::string_view accountPassword, const std::string_view host, uint16_t port, const std::string_view characterName, const std::string_view authenticatorToken, const std::string_view sessionKey);
+    // prepares the protocol to be fed recorded messages instead of a connection
+    void startReplay();
+
+    // headless sessions keep no game state, they only answer the login and ping
+    // handshakes and leave everything else to the lua onHeadlessMessage field,
+    // so many of them can share the process with the real game session. Only the first
+    // opcode of a message is seen, so they keep themselves alive with sendPing
+    void setHeadless(bool headless) { m_headless = headless; }
+    bool isHeadless() { return m_headless; }
     void send(const OutputMessagePtr& outputMessage) override;
 
     void sendExtendedOpcode(uint8_t opcode, const std::string_view buffer);
@@ -132,6 +142,10 @@ public:
     // otclient only
     void sendChangeMapAwareRange(int xrange, int yrange);
 
+    // the lua onOpcode hook is only called for opcodes that a module intercepts
+    static void setOpcodeHooked(uint8_t opcode, bool hooked) { m_hookedOpcodes.set(opcode, hooked); }
+    static bool isOpcodeHooked(uint8_t opcode) { return m_hookedOpcodes.test(opcode); }
+
 protected:
     void onConnect() override;
     void onRecv(const InputMessagePtr& inputMessage) override;
@@ -162,6 +176,7 @@ private:
     void parseCreatureType(const InputMessagePtr& msg);
     void parsePlayerHelpers(const InputMessagePtr& msg);
     void parseMessage(const InputMessagePtr& msg);
+    void parseHeadlessMessage(const InputMessagePtr& msg);
     void parsePendingGame(const InputMessagePtr& msg);
     void parseEnterGame(const InputMessagePtr& msg);
     void parseLogin(const InputMessagePtr& msg);
@@ -314,7 +329,8 @@ private:
     bool m_enableSendExtendedOpcode{ false },
         m_gameInitialized{ false },
         m_mapKnown{ false },
-        m_firstRecv{ true };
+        m_firstRecv{ true },
+        m_headless{ false };
 
     std::string m_accountName;
     std::string m_accountPassword;
@@ -322,4 +338,6 @@ private:
     std::string m_sessionKey;
     std::string m_characterName;
     LocalPlayerPtr m_localPlayer;
+
+    static std::bitset<256> m_hookedOpcodes;
 };
@@ -30,6 +30,7 @@
 #include "luavaluecasts.h"
 #include "map.h"
 #include "missile.h"
+#include "opcodestats.h"
 #include "statictext.h"
 #include "thingtypemanager.h"
 #include "tile.h"
@@ -41,8 +42,32 @@ void ProtocolGame::parseMessage(const InputMessagePtr& msg)
     int opcode = -1;
     int prevOpcode = -1;
 
+    // the lua hook is part of the measured time, it can be as expensive as the parser itself
+    const bool measure = g_opcodeStats.isEnabled();
+    const ticks_t messageStart = measure ? stdext::micros() : 0;
+    ticks_t opcodeStart = 0;
+    int opcodePos = 0;
+    uint32_t opcodes = 0;
+    int slowestOpcode = -1;
+    ticks_t slowestMicros = 0;
+
+    const auto recordOpcode = [&] {
+        const ticks_t elapsed = stdext::micros() - opcodeStart;
+        g_opcodeStats.record(opcode, msg->getReadPos() - opcodePos, elapsed);
+        ++opcodes;
+        if (elapsed >= slowestMicros) {
+            slowestOpcode = opcode;
+            slowestMicros = elapsed;
+        }
+    };
+
     try {
         while (!msg->eof()) {
+            if (measure) {
+                opcodeStart = stdext::micros();
+                opcodePos = msg->getReadPos();
+            }
+
             opcode = msg->getU8();
 
             // must be > so extended will be enabled before GameStart.
@@ -54,11 +79,16 @@ void ProtocolGame::parseMessage(const InputMessagePtr& msg)
             }
 
             // try to parse in lua first
-            const int readPos = msg->getReadPos();
-            if (callLuaField<bool>("onOpcode", opcode, msg))
-                continue;
-            msg->setReadPos(readPos);
-            // restore read pos
+            if (m_hookedOpcodes.test(opcode)) {
+                const int readPos = msg->getReadPos();
+                if (callLuaField<bool>("onOpcode", opcode, msg)) {
+                    if (measure)
+                        recordOpcode();
+                    continue;
+                }
+                // restore read pos
+                msg->setReadPos(readPos);
+            }
 
             switch (opcode) {
                 case Proto::GameServerLoginOrPendingState:
@@ -517,12 +547,50 @@ void ProtocolGame::parseMessage(const InputMessagePtr& msg)
                     throw Exception("unhandled opcode %d", opcode);
                     break;
             }
+            if (measure)
+                recordOpcode();
             prevOpcode = opcode;
         }
     } catch (stdext::exception& e) {
         g_logger.error(stdext::format("ProtocolGame parse message exception (%d bytes unread, last opcode is %d, prev opcode is %d): %s",
                                       msg->getUnreadSize(), opcode, prevOpcode, e.what()));
     }
+
+    if (measure)
+        g_opcodeStats.recordMessage(msg, opcodes, stdext::micros() - messageStart, slowestOpcode, slowestMicros);
+}
+
+void ProtocolGame::parseHeadlessMessage(const InputMessagePtr& msg)
+{
+    // without the full parser only the first opcode of a message can be located
+    const uint8_t opcode = msg->getU8();
+    const int readPos = msg->getReadPos();
+
+    try {
+        switch (opcode) {
+            case Proto::GameServerChallenge:
+                parseChallenge(msg);
+                break;
+            case Proto::GameServerLoginOrPendingState:
+                if (g_game.getFeature(Otc::GameLoginPending))
+                    sendEnterGame();
+                break;
+            case Proto::GameServerPing:
+            case Proto::GameServerPingBack:
+                if (((opcode == Proto::GameServerPing) && (g_game.getFeature(Otc::GameClientPing))) ||
+                   ((opcode == Proto::GameServerPingBack) && !g_game.getFeature(Otc::GameClientPing)))
+                    break;
+                sendPingBack();
+                break;
+            default:
+                break;
+        }
+    } catch (stdext::exception& e) {
+        g_logger.error(stdext::format("ProtocolGame headless message exception (opcode %d): %s", static_cast<int>(opcode), e.what()));
+    }
+
+    msg->setReadPos(readPos);
+    callLuaField("onHeadlessMessage", opcode, msg);
 }
 
 void ProtocolGame::parseLogin(const InputMessagePtr& msg)
@@ -22,9 +22,11 @@
 
 #include "spriteappearances.h"
 #include "game.h"
+#include "thingtypemanager.h"
 #include <framework/core/filestream.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/graphics/image.h>
+#include <framework/stdext/math.h>
 
 #include <framework/core/asyncdispatcher.h>
 #include <nlohmann/json.hpp>
@@ -58,9 +60,25 @@ bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr& sheet)
     }
 
     try {
+        const ticks_t startTime = stdext::micros();
+
         const FileStreamPtr& fin = g_resources.openFile(stdext::format("/things/%d/%s", g_game.getClientVersion(), sheet->file));
         fin->cache();
 
+        // decoded sheets on disk are only used for the exact file they were decoded from
+        const bool diskCache = m_sheetDiskCacheEnabled;
+        const uint32_t hash = diskCache ? stdext::adler32(fin->m_data.data(), fin->size()) : 0;
+        if (diskCache && loadCachedSheet(sheet, hash)) {
+            sheet->lastUse = stdext::millis();
+            sheet->loaded = true;
+            sheet->loading = false;
+
+            ++m_loadedSheets;
+            ++m_stats.diskLoads;
+            m_stats.diskLoadTime += stdext::micros() - startTime;
+            return true;
+        }
+
         const auto decompressed = std::make_unique<uint8_t[]>(LZMA_UNCOMPRESSED_SIZE); // uncompressed size, bmp file + 122 bytes header
 
         /*
@@ -147,11 +165,20 @@ bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr& sheet)
             }
         }
 
-        sheet->data = std::make_unique<uint8_t[]>(LZMA_UNCOMPRESSED_SIZE);
+        sheet->data = std::shared_ptr<uint8_t[]>(new uint8_t[BYTES_IN_SPRITE_SHEET]);
         std::memcpy(sheet->data.get(), bufferStart, BYTES_IN_SPRITE_SHEET);
 
+        if (diskCache) {
+            saveCachedSheet(sheet, hash);
+        }
+
+        sheet->lastUse = stdext::millis();
         sheet->loaded = true;
         sheet->loading = false;
+
+        ++m_loadedSheets;
+        ++m_stats.decodes;
+        m_stats.decodeTime += stdext::micros() - startTime;
         return true;
     } catch (std::exception& e) {
         g_logger.error(stdext::format("Failed to load single sprite sheet '%s': %s", sheet->file, e.what()));
@@ -159,51 +186,252 @@ bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr& sheet)
     }
 }
 
+std::string SpriteAppearances::getSheetDiskCacheDir()
+{
+    return stdext::format("/sheet-cache/%d", g_game.getClientVersion());
+}
+
+bool SpriteAppearances::loadCachedSheet(const SpriteSheetPtr& sheet, uint32_t hash)
+{
+    const std::string path = stdext::format("%s/%s", getSheetDiskCacheDir(), sheet->file);
+    if (!g_resources.fileExists(path)) {
+        return false;
+    }
+
+    try {
+        // not cached in memory, the pixels are read straight into the sheet
+        const FileStreamPtr fin = g_resources.openFile(path);
+        if (fin->size() != SHEET_DISK_CACHE_HEADER_SIZE + BYTES_IN_SPRITE_SHEET || fin->getU32() != SHEET_DISK_CACHE_SIGNATURE ||
+            fin->getU32() != SHEET_DISK_CACHE_VERSION || fin->getU32() != hash) {
+            return false;
+        }
+
+        const auto data = std::shared_ptr<uint8_t[]>(new uint8_t[BYTES_IN_SPRITE_SHEET]);
+        if (fin->read(data.get(), BYTES_IN_SPRITE_SHEET) != BYTES_IN_SPRITE_SHEET) {
+            return false;
+        }
+
+        sheet->data = data;
+        return true;
+    } catch (std::exception& e) {
+        g_logger.warning(stdext::format("Failed to read decoded sprite sheet '%s': %s", path, e.what()));
+        return false;
+    }
+}
+
+void SpriteAppearances::saveCachedSheet(const SpriteSheetPtr& sheet, uint32_t hash)
+{
+    const std::string dir = getSheetDiskCacheDir();
+    const std::string path = stdext::format("%s/%s", dir, sheet->file);
+
+    try {
+        g_resources.makeDir(dir);
+
+        const FileStreamPtr fout = g_resources.createFile(path);
+        fout->addU32(SHEET_DISK_CACHE_SIGNATURE);
+        fout->addU32(SHEET_DISK_CACHE_VERSION);
+        fout->addU32(hash);
+        fout->write(sheet->data.get(), BYTES_IN_SPRITE_SHEET);
+        fout->close();
+
+        ++m_stats.diskWrites;
+    } catch (std::exception& e) {
+        // a partly written file would only be rejected on the next load
+        g_resources.deleteFile(path);
+        g_logger.warning(stdext::format("Failed to write decoded sprite sheet '%s': %s", path, e.what()));
+    }
+}
+
+void SpriteAppearances::clearSheetDiskCache()
+{
+    const std::string dir = getSheetDiskCacheDir();
+    for (const std::string& file : g_resources.listDirectoryFiles(dir)) {
+        g_resources.deleteFile(stdext::format("%s/%s", dir, file));
+    }
+}
+
 void SpriteAppearances::unload()
 {
+    // the composer workers must not be looking up the sheets being dropped
+    g_things.getTextureComposer().clear();
+
     m_spritesCount = 0;
     m_sheets.clear();
+    m_loadedSheets = 0;
 }
 
-SpriteSheetPtr SpriteAppearances::getSheetBySpriteId(int id, bool load /* = true */)
+void SpriteAppearances::addSpriteSheet(const SpriteSheetPtr& sheet)
 {
-    if (id == 0) {
-        return nullptr;
-    }
+    // the catalog usually lists the sheets in order, so this is an append
+    const auto it = std::upper_bound(m_sheets.begin(), m_sheets.end(), sheet->firstId, [](int id, const SpriteSheetPtr& other) {
+        return id < other->firstId;
+    });
+    m_sheets.insert(it, sheet);
+}
 
-    // find sheet
-    const auto sheetIt = std::find_if(m_sheets.begin(), m_sheets.end(), [=](const SpriteSheetPtr& sheet) {
-        return id >= sheet->firstId && id <= sheet->lastId;
+const SpriteSheetPtr& SpriteAppearances::findSheet(int id)
+{
+    static const SpriteSheetPtr nullSheet;
+
+    // the last sheet starting at or before the id, if the id is in its range
+    const auto it = std::upper_bound(m_sheets.begin(), m_sheets.end(), id, [](int id, const SpriteSheetPtr& sheet) {
+        return id < sheet->firstId;
     });
 
-    if (sheetIt == m_sheets.end()) {
-        return nullptr;
+    if (it == m_sheets.begin() || id > (*(it - 1))->lastId) {
+        return nullSheet;
+    }
+
+    return *(it - 1);
+}
+
+// returned by reference, composer workers call this and the sheets' reference counts are not atomic
+const SpriteSheetPtr& SpriteAppearances::getSheetBySpriteId(int id, bool load /* = true */)
+{
+    static const SpriteSheetPtr nullSheet;
+
+    if (id == 0) {
+        return nullSheet;
     }
 
-    const SpriteSheetPtr& sheet = *sheetIt;
+    const SpriteSheetPtr& sheet = findSheet(id);
+    if (!sheet) {
+        return nullSheet;
+    }
 
     if (!sheet->loaded && load) {
-        if (!sheet->loading) {
-            sheet->loading = true;
+        ++m_stats.misses;
+
+        // composer workers may look the sheet up at the same time
+        if (!sheet->loading.exchange(true)) {
             g_asyncDispatcher.dispatch([this, &sheet] {
-                loadSpriteSheet(sheet);
+                if (loadSpriteSheet(sheet))
+                    evictSheets(sheet);
             });
         }
 
-        return nullptr;
+        return nullSheet;
+    }
+
+    if (load) {
+        ++m_stats.hits;
+        sheet->lastUse = stdext::millis();
     }
 
     return sheet;
 }
 
+void SpriteAppearances::evictSheets(const SpriteSheetPtr& keep)
+{
+    // sheets finish loading on several threads, one of them trims the cache at a time
+    std::lock_guard lock(m_cacheMutex);
+
+    while (m_sheetCacheSize > 0 && getSheetCacheUsage() > m_sheetCacheSize) {
+        SpriteSheet* oldest = nullptr;
+        for (const auto& sheet : m_sheets) {
+            if (sheet.get() != keep.get() && sheet->loaded && (!oldest || sheet->lastUse < oldest->lastUse))
+                oldest = sheet.get();
+        }
+
+        if (!oldest)
+            break;
+
+        // sprites being read from it keep its pixels until they are done
+        std::lock_guard sheetLock(oldest->mutex);
+        if (!oldest->loaded)
+            continue;
+
+        oldest->data = nullptr;
+        oldest->loaded = false;
+        --m_loadedSheets;
+        ++m_stats.evictions;
+    }
+}
+
+std::map<std::string, double> SpriteAppearances::getSheetCacheStats()
+{
+    const uint32_t decodes = m_stats.decodes;
+    const uint32_t diskLoads = m_stats.diskLoads;
+
+    return {
+        { "sheets", m_sheets.size() },
+        { "loadedSheets", m_loadedSheets.load() },
+        { "usage", getSheetCacheUsage() },
+        { "size", m_sheetCacheSize },
+        { "hits", m_stats.hits.load() },
+        { "misses", m_stats.misses.load() },
+        { "decodes", decodes },
+        { "avgDecodeTime", decodes > 0 ? m_stats.decodeTime / 1000.0 / decodes : 0 },
+        { "evictions", m_stats.evictions.load() },
+        { "diskCache", m_sheetDiskCacheEnabled ? 1 : 0 },
+        { "diskLoads", diskLoads },
+        { "avgDiskLoadTime", diskLoads > 0 ? m_stats.diskLoadTime / 1000.0 / diskLoads : 0 },
+        { "diskWrites", m_stats.diskWrites.load() }
+    };
+}
+
+void SpriteAppearances::resetSheetCacheStats()
+{
+    m_stats.hits = 0;
+    m_stats.misses = 0;
+    m_stats.decodes = 0;
+    m_stats.evictions = 0;
+    m_stats.decodeTime = 0;
+    m_stats.diskLoads = 0;
+    m_stats.diskWrites = 0;
+    m_stats.diskLoadTime = 0;
+}
+
+std::map<std::string, double> SpriteAppearances::benchmarkSheetLookup(int lookups)
+{
+    if (m_sheets.empty() || lookups <= 0)
+        return {};
+
+    std::vector<int> ids(lookups);
+    for (int& id : ids)
+        id = stdext::random_range(1, m_spritesCount - 1);
+
+    // found counts are returned, so neither loop can be optimized away
+    uint32_t scanned = 0, indexed = 0;
+
+    ticks_t startTime = stdext::micros();
+    for (const int id : ids) {
+        const auto it = std::find_if(m_sheets.begin(), m_sheets.end(), [=](const SpriteSheetPtr& sheet) {
+            return id >= sheet->firstId && id <= sheet->lastId;
+        });
+        scanned += it != m_sheets.end();
+    }
+    const ticks_t scanTime = stdext::micros() - startTime;
+
+    startTime = stdext::micros();
+    for (const int id : ids)
+        indexed += findSheet(id) != nullptr;
+    const ticks_t indexTime = stdext::micros() - startTime;
+
+    return {
+        { "lookups", lookups },
+        { "sheets", m_sheets.size() },
+        { "scanned", scanned },
+        { "indexed", indexed },
+        { "scanTime", scanTime * 1000.0 / lookups },
+        { "indexTime", indexTime * 1000.0 / lookups }
+    };
+}
+
 ImagePtr SpriteAppearances::getSpriteImage(int id)
 {
     try {
-        const SpriteSheetPtr sheet = getSheetBySpriteId(id);
+        const SpriteSheetPtr& sheet = getSheetBySpriteId(id);
         if (!sheet) {
             return nullptr;
         }
 
+        // the cache may drop the sheet while its sprite is being copied
+        const auto sheetData = sheet->getData();
+        if (!sheetData) {
+            return nullptr;
+        }
+
         const Size& size = sheet->getSpriteSize();
 
         ImagePtr image(new Image(size));
@@ -217,7 +445,7 @@ ImagePtr SpriteAppearances::getSpriteImage(int id)
         const int spriteWidthBytes = size.width() * 4;
 
         for (int height = size.height() * spriteRow, offset = 0; height < size.height() + (spriteRow * size.height()); height++, offset++) {
-            std::memcpy(&pixelData[offset * spriteWidthBytes], &sheet->data[(height * SPRITE_SHEET_WIDTH_BYTES) + (spriteColumn * spriteWidthBytes)], spriteWidthBytes);
+            std::memcpy(&pixelData[offset * spriteWidthBytes], &sheetData[(height * SPRITE_SHEET_WIDTH_BYTES) + (spriteColumn * spriteWidthBytes)], spriteWidthBytes);
         }
 
         if (!image->hasTransparentPixel()) {
@@ -248,15 +476,19 @@ void SpriteAppearances::saveSpriteToFile(int id, const std::string& file)
 
 void SpriteAppearances::saveSheetToFileBySprite(int id, const std::string& file)
 {
-    const SpriteSheetPtr sheet = getSheetBySpriteId(id);
+    const SpriteSheetPtr& sheet = getSheetBySpriteId(id);
     if (sheet) {
-        Image image({ 384 }, 4, sheet->data.get());
-        image.savePNG(file);
+        saveSheetToFile(sheet, file);
     }
 }
 
 void SpriteAppearances::saveSheetToFile(const SpriteSheetPtr& sheet, const std::string& file)
 {
-    Image image({ 384 }, 4, sheet->data.get());
+    const auto sheetData = sheet->getData();
+    if (!sheetData) {
+        return;
+    }
+
+    Image image({ 384 }, 4, sheetData.get());
     image.savePNG(file);
 }
@@ -22,10 +22,13 @@
 
 #pragma once
 
+#include "config.h"
 #include <framework/core/declarations.h>
 #include <framework/graphics/declarations.h>
 #include <framework/luaengine/luaobject.h>
 
+#include <atomic>
+
 enum class SpriteLayout
 {
     ONE_BY_ONE = 0,
@@ -54,13 +57,21 @@ public:
         return size;
     }
 
+    // the pixels are shared with whoever reads them, so the cache can drop them at any time
+    std::shared_ptr<uint8_t[]> getData()
+    {
+        std::lock_guard lock(mutex);
+        return data;
+    }
+
     int firstId = 0;
     int lastId = 0;
     SpriteLayout spriteLayout = SpriteLayout::ONE_BY_ONE;
-    std::unique_ptr<uint8_t[]> data;
+    std::shared_ptr<uint8_t[]> data;
     std::string file;
-    bool loaded = false;
-    bool loading = false;
+    std::atomic_bool loaded = false;
+    std::atomic_bool loading = false;
+    std::atomic<ticks_t> lastUse = 0;
 
     std::mutex mutex;
 };
@@ -69,6 +80,13 @@ public:
 class SpriteAppearances
 {
 public:
+    // roughly 450 decoded sheets
+    static constexpr uint64_t DEFAULT_SHEET_CACHE_SIZE = 256 * 1024 * 1024;
+    // 'OTSC', decoded sheets on disk start with it, their format version and the hash of the source file
+    static constexpr uint32_t SHEET_DISK_CACHE_SIGNATURE = 0x4353544F;
+    static constexpr uint32_t SHEET_DISK_CACHE_VERSION = 1;
+    static constexpr uint32_t SHEET_DISK_CACHE_HEADER_SIZE = 12;
+
     void init();
     void terminate();
 
@@ -80,19 +98,55 @@ public:
     bool loadSpriteSheet(const SpriteSheetPtr& sheet);
     void saveSheetToFileBySprite(int id, const std::string& file);
     void saveSheetToFile(const SpriteSheetPtr& sheet, const std::string& file);
-    SpriteSheetPtr getSheetBySpriteId(int id, bool load = true);
+    const SpriteSheetPtr& getSheetBySpriteId(int id, bool load = true);
 
-    void addSpriteSheet(const SpriteSheetPtr& sheet)
-    {
-        m_sheets.push_back(sheet);
-    }
+    void addSpriteSheet(const SpriteSheetPtr& sheet);
 
     ImagePtr getSpriteImage(int id);
     void saveSpriteToFile(int id, const std::string& file);
 
+    // 0 keeps every decoded sheet
+    void setSheetCacheSize(uint64_t bytes) { m_sheetCacheSize = bytes; }
+    uint64_t getSheetCacheSize() { return m_sheetCacheSize; }
+    uint64_t getSheetCacheUsage() { return static_cast<uint64_t>(m_loadedSheets) * BYTES_IN_SPRITE_SHEET; }
+    std::map<std::string, double> getSheetCacheStats();
+    void resetSheetCacheStats();
+
+    std::map<std::string, double> benchmarkSheetLookup(int lookups);
+
+    // keeps decoded sheets in the user write directory, so they are not decoded again on the next start
+    void setSheetDiskCacheEnabled(bool enable) { m_sheetDiskCacheEnabled = enable; }
+    bool isSheetDiskCacheEnabled() { return m_sheetDiskCacheEnabled; }
+    void clearSheetDiskCache();
+
 private:
+    const SpriteSheetPtr& findSheet(int id);
+    void evictSheets(const SpriteSheetPtr& keep);
+
+    std::string getSheetDiskCacheDir();
+    bool loadCachedSheet(const SpriteSheetPtr& sheet, uint32_t hash);
+    void saveCachedSheet(const SpriteSheetPtr& sheet, uint32_t hash);
+
     int m_spritesCount{ 0 };
+    // sorted by first sprite id
     std::vector<SpriteSheetPtr> m_sheets;
+
+    uint64_t m_sheetCacheSize{ DEFAULT_SHEET_CACHE_SIZE };
+    std::atomic<uint32_t> m_loadedSheets{ 0 };
+    std::mutex m_cacheMutex;
+    std::atomic_bool m_sheetDiskCacheEnabled{ false };
+
+    struct
+    {
+        std::atomic<uint32_t> hits{ 0 },
+            misses{ 0 },
+            decodes{ 0 },
+            evictions{ 0 },
+            diskLoads{ 0 },
+            diskWrites{ 0 };
+        std::atomic<uint64_t> decodeTime{ 0 },
+            diskLoadTime{ 0 };
+    } m_stats;
 };
 
 extern SpriteAppearances g_spriteAppearances;
@@ -23,6 +23,7 @@
 #include "spritemanager.h"
 #include "game.h"
 #include "spriteappearances.h"
+#include "thingtypemanager.h"
 #include <framework/core/filestream.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/graphics/image.h>
@@ -39,6 +40,10 @@ void SpriteManager::terminate()
 
 bool SpriteManager::loadSpr(std::string file)
 {
+    // the composer workers must not be reading the sprites being replaced
+    g_things.getTextureComposer().clear();
+
+    std::unique_lock lock(m_mutex);
     m_spritesCount = 0;
     m_signature = 0;
     m_loaded = false;
@@ -57,6 +62,7 @@ bool SpriteManager::loadSpr(std::string file)
         m_spritesCount = g_game.getFeature(Otc::GameSpritesU32) ? m_spritesFile->getU32() : m_spritesFile->getU16();
         m_spritesOffset = m_spritesFile->tell();
         m_loaded = true;
+        lock.unlock();
         g_lua.callGlobalField("g_sprites", "onLoadSpr", file);
         return true;
     } catch (stdext::exception& e) {
@@ -70,6 +76,8 @@ void SpriteManager::saveSpr(const std::string& fileName)
     if (!m_loaded)
         throw Exception("failed to save, spr is not loaded");
 
+    std::lock_guard lock(m_mutex);
+
     try {
         const FileStreamPtr fin = g_resources.createFile(fileName);
         if (!fin)
@@ -121,6 +129,9 @@ void SpriteManager::saveSpr(const std::string& fileName)
 
 void SpriteManager::unload()
 {
+    g_things.getTextureComposer().clear();
+
+    std::lock_guard lock(m_mutex);
     m_spritesCount = 0;
     m_signature = 0;
     m_spritesFile = nullptr;
@@ -132,6 +143,8 @@ ImagePtr SpriteManager::getSpriteImage(int id)
         return g_spriteAppearances.getSpriteImage(id);
     }
 
+    std::lock_guard lock(m_mutex);
+
     try {
         if (id == 0 || !m_spritesFile)
             return nullptr;
@@ -62,6 +62,9 @@ private:
     int m_spritesCount{ 0 },
         m_spritesOffset{ 0 };
     FileStreamPtr m_spritesFile;
+
+    // sprites are also read by the texture composer workers
+    std::mutex m_mutex;
 };
 
 extern SpriteManager g_sprites;
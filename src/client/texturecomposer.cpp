@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "texturecomposer.h"
+#include "thingtype.h"
+
+void TextureComposer::init()
+{
+    m_running = true;
+
+    const uint32_t workers = std::clamp<uint32_t>(std::thread::hardware_concurrency() / 2, 1, MAX_WORKERS);
+    for (uint32_t i = 0; i < workers; ++i)
+        m_workers.emplace_back([this] { workerLoop(); });
+}
+
+void TextureComposer::terminate()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_running = false;
+        m_queue.clear();
+    }
+
+    m_condition.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+
+    m_jobs.clear();
+}
+
+void TextureComposer::clear()
+{
+    // the jobs hold thing types, whose reference counts are only touched by the main thread,
+    // so they are released here once no worker is using them
+    std::map<JobKey, JobPtr> jobs;
+    {
+        std::unique_lock lock(m_mutex);
+        m_queue.clear();
+        m_jobs.swap(jobs);
+        m_idleCondition.wait(lock, [this] { return m_busyWorkers == 0; });
+    }
+}
+
+void TextureComposer::setEnabled(bool enable)
+{
+    if (m_enabled == enable)
+        return;
+
+    m_enabled = enable;
+    clear();
+}
+
+ComposedTexturePtr TextureComposer::request(const ThingTypePtr& thingType, int animationPhase, TextureType txtType, uint32_t priority)
+{
+    std::lock_guard lock(m_mutex);
+
+    const auto it = m_jobs.find({ thingType.get(), animationPhase, txtType });
+    if (it == m_jobs.end()) {
+        const auto job = std::make_shared<Job>(Job{ thingType, animationPhase, txtType, priority, stdext::micros(), nullptr, false });
+        m_jobs.emplace(JobKey{ thingType.get(), animationPhase, txtType }, job);
+        m_queue.emplace_back(job);
+        ++m_stats.requests;
+        m_condition.notify_one();
+        return nullptr;
+    }
+
+    const JobPtr& job = it->second;
+    if (!job->done) {
+        // the thing moved closer to or away from the focus since it was queued
+        job->priority = priority;
+        return nullptr;
+    }
+
+    ComposedTexturePtr result = job->result;
+    m_jobs.erase(it);
+    return result;
+}
+
+uint32_t TextureComposer::getPriority(const Point& dest)
+{
+    if (!m_hasFocus)
+        return 0;
+
+    const int64_t dx = dest.x - m_focus.x, dy = dest.y - m_focus.y;
+    return static_cast<uint32_t>(std::min<int64_t>(dx * dx + dy * dy, UINT32_MAX - 1));
+}
+
+std::map<std::string, double> TextureComposer::getStats()
+{
+    std::lock_guard lock(m_mutex);
+
+    const double done = std::max<uint32_t>(m_stats.composed + m_stats.failed, 1);
+    return {
+        { "enabled", m_enabled ? 1 : 0 },
+        { "workers", m_workers.size() },
+        { "queued", m_queue.size() },
+        { "requests", m_stats.requests },
+        { "composed", m_stats.composed },
+        { "failed", m_stats.failed },
+        { "avgWaitTime", m_stats.waitTime / done },
+        { "avgComposeTime", m_stats.composeTime / done },
+        { "maxWaitTime", m_stats.maxWaitTime }
+    };
+}
+
+void TextureComposer::resetStats()
+{
+    std::lock_guard lock(m_mutex);
+    m_stats = {};
+}
+
+void TextureComposer::workerLoop()
+{
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        m_condition.wait(lock, [this] { return !m_queue.empty() || !m_running; });
+        if (!m_running)
+            return;
+
+        const auto it = std::min_element(m_queue.begin(), m_queue.end(), [](const JobPtr& a, const JobPtr& b) { return a->priority < b->priority; });
+        std::swap(*it, m_queue.back());
+        const JobPtr job = std::move(m_queue.back());
+        m_queue.pop_back();
+        ++m_busyWorkers;
+
+        lock.unlock();
+        const ticks_t startedAt = stdext::micros();
+        ComposedTexturePtr result = job->thingType->composeTexture(job->animationPhase, job->txtType);
+        const ticks_t finishedAt = stdext::micros();
+        lock.lock();
+
+        job->result = std::move(result);
+        job->done = true;
+
+        ++(job->result ? m_stats.composed : m_stats.failed);
+        const double waitTime = (finishedAt - job->queuedAt) / 1000.;
+        m_stats.waitTime += waitTime;
+        m_stats.composeTime += (finishedAt - startedAt) / 1000.;
+        m_stats.maxWaitTime = std::max<double>(m_stats.maxWaitTime, waitTime);
+
+        if (--m_busyWorkers == 0)
+            m_idleCondition.notify_all();
+    }
+}
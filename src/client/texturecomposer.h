@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "declarations.h"
+#include <framework/graphics/declarations.h>
+
+#include <condition_variable>
+#include <thread>
+
+enum class TextureType;
+
+// frames of a thing type animation phase, with the rect of each frame in the image
+// and of the visible pixels inside it
+struct ComposedTexture
+{
+    ImagePtr image;
+    std::vector<Rect> drawRects;
+    std::vector<Rect> originRects;
+};
+
+// composes thing textures on its own workers, so the first draw of a thing type doesn't
+// decode and blit its sprites on the main thread; textures drawn closest to the focus,
+// the camera while the map is drawn, are composed first
+class TextureComposer
+{
+public:
+    void init();
+    void terminate();
+
+    // drops the queued requests and waits for the running ones, before the sprites change
+    void clear();
+
+    void setEnabled(bool enable);
+    bool isEnabled() { return m_enabled; }
+
+    // the composed texture once a worker is done with it, nullptr while it is queued or composing
+    // and when it failed; requesting it again queues it once more or updates its priority
+    ComposedTexturePtr request(const ThingTypePtr& thingType, int animationPhase, TextureType txtType, uint32_t priority);
+
+    void setFocus(const Point& focus) { m_focus = focus; m_hasFocus = true; }
+    void clearFocus() { m_hasFocus = false; }
+    uint32_t getPriority(const Point& dest);
+
+    std::map<std::string, double> getStats();
+    void resetStats();
+
+private:
+    enum { MAX_WORKERS = 4 };
+
+    // workers only read the thing type, the job is released by the main thread
+    struct Job
+    {
+        ThingTypePtr thingType;
+        int animationPhase;
+        TextureType txtType;
+        uint32_t priority;
+        ticks_t queuedAt;
+        ComposedTexturePtr result;
+        bool done{ false };
+    };
+    using JobPtr = std::shared_ptr<Job>;
+    using JobKey = std::tuple<ThingType*, int, TextureType>;
+
+    struct Stats
+    {
+        uint32_t requests{ 0 };
+        uint32_t composed{ 0 };
+        uint32_t failed{ 0 };
+        double waitTime{ 0 };
+        double composeTime{ 0 };
+        double maxWaitTime{ 0 };
+    };
+
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::vector<JobPtr> m_queue;
+    std::map<JobKey, JobPtr> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_condition, m_idleCondition;
+    uint32_t m_busyWorkers{ 0 };
+    bool m_running{ false };
+
+    Point m_focus;
+    bool m_hasFocus{ false };
+    bool m_enabled{ true };
+
+    Stats m_stats;
+};
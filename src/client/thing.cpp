@@ -111,3 +111,9 @@ const ThingTypePtr& Thing::getThingType()
 {
     return g_things.getNullThingType();
 }
+
+uint64_t Thing::getThingFlags()
+{
+    const ThingTypePtr& thingType = getThingType();
+    return g_things.getThingFlags(thingType->getId(), thingType->getCategory());
+}
@@ -71,6 +71,9 @@ public:
 
     // type shortcuts
     virtual const ThingTypePtr& getThingType();
+    // packed ThingFlag/ThingAttr bits of the thing type, read from ThingTypeManager's tables
+    virtual uint64_t getThingFlags();
+    bool hasThingFlag(uint8_t flag) { return ::hasThingFlag(getThingFlags(), flag); }
     Size getSize() { return getThingType()->getSize(); }
     int getWidth() { return getThingType()->getWidth(); }
     int getHeight() { return getThingType()->getHeight(); }
@@ -97,44 +100,44 @@ public:
     int getLensHelp() { return getThingType()->getLensHelp(); }
     int getClothSlot() { return getThingType()->getClothSlot(); }
     int getElevation() { return getThingType()->getElevation(); }
-    bool isGround() { return getThingType()->isGround(); }
-    bool isGroundBorder() { return getThingType()->isGroundBorder(); }
-    bool isTopGround() { return getThingType()->isTopGround(); }
-    bool isTopGroundBorder() { return getThingType()->isTopGroundBorder(); }
-    bool isSingleGround() { return getThingType()->isSingleGround(); }
-    bool isSingleGroundBorder() { return getThingType()->isSingleGroundBorder(); }
-    bool isOnBottom() { return getThingType()->isOnBottom(); }
-    bool isOnTop() { return getThingType()->isOnTop(); }
+    bool isGround() { return hasThingFlag(ThingAttrGround); }
+    bool isGroundBorder() { return hasThingFlag(ThingAttrGroundBorder); }
+    bool isTopGround() { return isGround() && !isSingleDimension(); }
+    bool isTopGroundBorder() { return isGroundBorder() && !isSingleDimension(); }
+    bool isSingleGround() { return isGround() && isSingleDimension(); }
+    bool isSingleGroundBorder() { return isGroundBorder() && isSingleDimension(); }
+    bool isOnBottom() { return hasThingFlag(ThingAttrOnBottom); }
+    bool isOnTop() { return hasThingFlag(ThingAttrOnTop); }
     bool isCommon() { return !isGround() && !isGroundBorder() && !isOnTop() && !isCreature() && !isOnBottom(); }
     virtual bool isContainer() { return getThingType()->isContainer(); }
     bool isStackable() { return getThingType()->isStackable(); }
-    bool isForceUse() { return getThingType()->isForceUse(); }
+    bool isForceUse() { return hasThingFlag(ThingAttrForceUse); }
     bool isMultiUse() { return getThingType()->isMultiUse(); }
     bool isWritable() { return getThingType()->isWritable(); }
     bool isChargeable() { return getThingType()->isChargeable(); }
     bool isWritableOnce() { return getThingType()->isWritableOnce(); }
     bool isFluidContainer() { return getThingType()->isFluidContainer(); }
-    bool isSplash() { return getThingType()->isSplash(); }
-    bool isNotWalkable() { return getThingType()->isNotWalkable(); }
-    bool isNotMoveable() { return getThingType()->isNotMoveable(); }
-    bool isMoveable() { return !getThingType()->isNotMoveable(); }
-    bool blockProjectile() { return getThingType()->blockProjectile(); }
-    bool isNotPathable() { return getThingType()->isNotPathable(); }
+    bool isSplash() { return hasThingFlag(ThingAttrSplash); }
+    bool isNotWalkable() { return hasThingFlag(ThingAttrNotWalkable); }
+    bool isNotMoveable() { return hasThingFlag(ThingAttrNotMoveable); }
+    bool isMoveable() { return !hasThingFlag(ThingAttrNotMoveable); }
+    bool blockProjectile() { return hasThingFlag(ThingAttrBlockProjectile); }
+    bool isNotPathable() { return hasThingFlag(ThingAttrNotPathable); }
     bool isPickupable() { return getThingType()->isPickupable(); }
     bool isHangable() { return getThingType()->isHangable(); }
-    bool isHookSouth() { return getThingType()->isHookSouth(); }
-    bool isHookEast() { return getThingType()->isHookEast(); }
+    bool isHookSouth() { return hasThingFlag(ThingAttrHookSouth); }
+    bool isHookEast() { return hasThingFlag(ThingAttrHookEast); }
     bool isRotateable() { return getThingType()->isRotateable(); }
     bool isDontHide() { return getThingType()->isDontHide(); }
     bool isTranslucent() { return getThingType()->isTranslucent(); }
-    bool hasDisplacement() { return getThingType()->hasDisplacement(); }
-    bool hasElevation() { return getThingType()->hasElevation(); }
-    bool isLyingCorpse() { return getThingType()->isLyingCorpse(); }
+    bool hasDisplacement() { return hasThingFlag(ThingAttrDisplacement); }
+    bool hasElevation() { return hasThingFlag(ThingAttrElevation); }
+    bool isLyingCorpse() { return hasThingFlag(ThingAttrLyingCorpse); }
     bool isAnimateAlways() { return getThingType()->isAnimateAlways(); }
     bool hasMiniMapColor() { return getThingType()->hasMiniMapColor(); }
     bool hasLensHelp() { return getThingType()->hasLensHelp(); }
-    bool isFullGround() { return getThingType()->isFullGround(); }
-    bool isIgnoreLook() { return getThingType()->isIgnoreLook(); }
+    bool isFullGround() { return hasThingFlag(ThingAttrFullGround); }
+    bool isIgnoreLook() { return hasThingFlag(ThingAttrLook); }
     bool isCloth() { return getThingType()->isCloth(); }
     bool isMarketable() { return getThingType()->isMarketable(); }
     bool isUsable() { return getThingType()->isUsable(); }
@@ -143,7 +146,7 @@ public:
     bool isTopEffect() { return getThingType()->isTopEffect(); }
     bool hasAction() { return getThingType()->hasAction(); }
     bool isOpaque() { return getThingType()->isOpaque(); }
-    bool isSingleDimension() { return getThingType()->isSingleDimension(); }
+    bool isSingleDimension() { return hasThingFlag(ThingFlagSingleDimension); }
     bool isTall(const bool useRealSize = false) { return getThingType()->isTall(useRealSize); }
     uint16_t getClassification() { return getThingType()->getClassification(); }
 
@@ -26,6 +26,7 @@
 #include "map.h"
 #include "spriteappearances.h"
 #include "spritemanager.h"
+#include "thingtypemanager.h"
 
 #include <framework/core/eventdispatcher.h>
 #include <framework/core/filestream.h>
@@ -709,8 +710,8 @@ void ThingType::draw(const Point& dest, float scaleFactor, int layer, int xPatte
     if (animationPhase >= m_animationPhases)
         return;
 
-    const TexturePtr& texture = getTexture(animationPhase, textureType); // texture might not exists, neither its rects.
-    if (!texture)
+    const auto& texture = getTextureRegion(animationPhase, textureType, g_things.getTextureComposer().getPriority(dest)); // texture might not exists, neither its rects.
+    if (!texture.texture)
         return;
 
     const auto& textureRectList = m_texturesFramesRects[animationPhase];
@@ -720,7 +721,7 @@ void ThingType::draw(const Point& dest, float scaleFactor, int layer, int xPatte
         return;
 
     const Point& textureOffset = m_texturesFramesOffsets[animationPhase][frameIndex];
-    const Rect& textureRect = textureRectList[frameIndex];
+    const Rect textureRect = textureRectList[frameIndex].translated(texture.offset);
 
     const Rect screenRect(dest + (textureOffset - m_displacement - (m_size.toPoint() - Point(1)) * SPRITE_SIZE) * scaleFactor, textureRect.size() * scaleFactor);
 
@@ -728,7 +729,7 @@ void ThingType::draw(const Point& dest, float scaleFactor, int layer, int xPatte
         if (m_opacity < 1.0f)
             color.setAlpha(m_opacity);
 
-        g_drawPool.addTexturedRect(screenRect, texture, textureRect, color, dest, drawBuffer);
+        g_drawPool.addTexturedRect(screenRect, texture.texture, textureRect, color, dest, drawBuffer);
     }
 
     if (lightView && hasLight() && flags & Otc::DrawLights) {
@@ -739,20 +740,74 @@ void ThingType::draw(const Point& dest, float scaleFactor, int layer, int xPatte
     }
 }
 
-TexturePtr ThingType::getTexture(int animationPhase, const TextureType txtType)
+const TextureAtlas::Region& ThingType::getTextureRegion(int animationPhase, const TextureType txtType, uint32_t priority)
 {
+    static const TextureAtlas::Region nullRegion;
+
     if (m_null) {
-        return nullptr;
+        return nullRegion;
     }
 
-    const bool allBlank = txtType == TextureType::ALL_BLANK,
-        smooth = txtType == TextureType::SMOOTH;
+    const bool smooth = txtType == TextureType::SMOOTH;
 
-    TexturePtr& animationPhaseTexture = (
-        allBlank ? m_blankTextures :
+    TextureAtlas::Region& animationPhaseTexture = (
+        txtType == TextureType::ALL_BLANK ? m_blankTextures :
         smooth ? m_smoothTextures : m_textures)[animationPhase];
 
-    if (animationPhaseTexture) return animationPhaseTexture;
+    if (animationPhaseTexture.texture) {
+        auto& atlas = g_things.getTextureAtlas();
+        if (atlas.isValid(animationPhaseTexture)) {
+            atlas.use(animationPhaseTexture);
+            return animationPhaseTexture;
+        }
+
+        // its atlas page was given to other textures, so it is built again
+        animationPhaseTexture = {};
+    }
+
+    // custom images are loaded through the resource manager, which is kept to the main thread
+    ComposedTexturePtr composed;
+    auto& composer = g_things.getTextureComposer();
+    if (composer.isEnabled() && (animationPhase != 0 || m_customImage.empty())) {
+        // nothing is drawn until a worker has composed it
+        composed = composer.request(static_self_cast<ThingType>(), animationPhase, txtType, priority);
+    } else
+        composed = composeTexture(animationPhase, txtType);
+
+    if (!composed)
+        return nullRegion;
+
+    // the frames are laid out by the first texture built for the phase, the other types reuse it
+    if (m_texturesFramesRects[animationPhase].empty()) {
+        auto& originRects = m_texturesFramesOriginRects[animationPhase];
+        auto& offsets = m_texturesFramesOffsets[animationPhase];
+
+        originRects = composed->originRects;
+        offsets.resize(originRects.size());
+        for (uint32_t i = 0; i < originRects.size(); ++i)
+            offsets[i] = composed->drawRects[i].topLeft() - originRects[i].topLeft();
+
+        layoutTextureFrames(animationPhase, composed->drawRects);
+    }
+
+    m_opaque = !composed->image->hasTransparentPixel();
+
+    const ImagePtr textureImage = cropTextureFrames(animationPhase, composed->image);
+
+    // smooth textures are scaled with filtering and mipmaps, which would bleed across atlas neighbors
+    if (!smooth && g_things.isTextureAtlasEnabled() && g_things.getTextureAtlas().add(textureImage, animationPhaseTexture))
+        return animationPhaseTexture;
+
+    animationPhaseTexture.texture = TexturePtr(new Texture(textureImage, true, false, m_size.area() == 1 && !hasElevation(), false));
+    if (smooth)
+        animationPhaseTexture.texture->setSmooth(true);
+
+    return animationPhaseTexture;
+}
+
+ComposedTexturePtr ThingType::composeTexture(int animationPhase, const TextureType txtType)
+{
+    const bool allBlank = txtType == TextureType::ALL_BLANK;
 
     // we don't need layers in common items, they will be pre-drawn
     int textureLayers = 1;
@@ -768,13 +823,14 @@ TexturePtr ThingType::getTexture(int animationPhase, const TextureType txtType)
     const Size textureSize = getBestTextureDimension(m_size.width(), m_size.height(), indexSize);
     const ImagePtr fullImage = useCustomImage ? Image::load(m_customImage) : ImagePtr(new Image(textureSize * SPRITE_SIZE));
 
-    m_texturesFramesRects[animationPhase].resize(indexSize);
-    m_texturesFramesOriginRects[animationPhase].resize(indexSize);
-    m_texturesFramesOffsets[animationPhase].resize(indexSize);
+    const auto composed = std::make_shared<ComposedTexture>();
+    composed->image = fullImage;
+    composed->drawRects.resize(indexSize);
+    composed->originRects.resize(indexSize);
 
     const bool protobufSupported = g_game.getProtocolVersion() >= 1281;
 
-    static Color maskColors[] = { Color::red, Color::green, Color::blue, Color::yellow };
+    static const Color maskColors[] = { Color::red, Color::green, Color::blue, Color::yellow };
 
     for (int z = 0; z < m_numPatternZ; ++z) {
         for (int y = 0; y < m_numPatternY; ++y) {
@@ -847,9 +903,8 @@ TexturePtr ThingType::getTexture(int animationPhase, const TextureType txtType)
                         }
                     }
 
-                    m_texturesFramesRects[animationPhase][frameIndex] = drawRect;
-                    m_texturesFramesOriginRects[animationPhase][frameIndex] = Rect(framePos, Size(m_size.width(), m_size.height()) * SPRITE_SIZE);
-                    m_texturesFramesOffsets[animationPhase][frameIndex] = drawRect.topLeft() - framePos;
+                    composed->drawRects[frameIndex] = drawRect;
+                    composed->originRects[frameIndex] = Rect(framePos, Size(m_size.width(), m_size.height()) * SPRITE_SIZE);
                 }
             }
         }
@@ -858,13 +913,100 @@ TexturePtr ThingType::getTexture(int animationPhase, const TextureType txtType)
     if (m_opacity < 1.0f)
         fullImage->setTransparentPixel(true);
 
-    m_opaque = !fullImage->hasTransparentPixel();
+    return composed;
+}
 
-    animationPhaseTexture = TexturePtr(new Texture(fullImage, true, false, m_size.area() == 1 && !hasElevation(), false));
-    if (smooth)
-        animationPhaseTexture->setSmooth(true);
+void ThingType::clearTextures()
+{
+    for (auto* textures : { &m_textures, &m_blankTextures, &m_smoothTextures })
+        std::fill(textures->begin(), textures->end(), TextureAtlas::Region());
+}
 
-    return animationPhaseTexture;
+uint32_t ThingType::evictTextures(ticks_t lastUse)
+{
+    auto& atlas = g_things.getTextureAtlas();
+
+    uint32_t evicted = 0;
+    for (auto* textures : { &m_textures, &m_blankTextures, &m_smoothTextures }) {
+        for (auto& region : *textures) {
+            if (!region.texture)
+                continue;
+
+            // atlas regions go with their page, standalone textures go by themselves
+            if (atlas.isValid(region) && (region.page != UINT16_MAX || region.texture->getLastUse() >= lastUse))
+                continue;
+
+            region = {};
+            ++evicted;
+        }
+    }
+
+    return evicted;
+}
+
+void ThingType::layoutTextureFrames(int animationPhase, const std::vector<Rect>& drawRects)
+{
+    // frames are packed without the transparent space around them, tallest first on
+    // rows about as wide as the texture is tall, with a pixel of space between them
+    std::vector<uint32_t> order;
+    int area = 0, maxWidth = 0;
+    for (uint32_t i = 0; i < drawRects.size(); ++i) {
+        const Rect& drawRect = drawRects[i];
+        if (!drawRect.isValid())
+            continue;
+
+        order.emplace_back(i);
+        area += (drawRect.width() + 1) * (drawRect.height() + 1);
+        maxWidth = std::max<int>(maxWidth, drawRect.width());
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return drawRects[a].height() > drawRects[b].height(); });
+
+    const int rowWidth = std::max<int>(maxWidth, std::ceil(std::sqrt(area)));
+
+    auto& framesRects = m_texturesFramesRects[animationPhase];
+    framesRects.assign(drawRects.size(), Rect());
+
+    Point pos;
+    int rowHeight = 0;
+    for (const uint32_t i : order) {
+        const Rect& drawRect = drawRects[i];
+        if (pos.x + drawRect.width() > rowWidth) {
+            pos = Point(0, pos.y + rowHeight + 1);
+            rowHeight = 0;
+        }
+
+        framesRects[i] = Rect(pos, drawRect.size());
+        pos.x += drawRect.width() + 1;
+        rowHeight = std::max<int>(rowHeight, drawRect.height());
+    }
+}
+
+ImagePtr ThingType::cropTextureFrames(int animationPhase, const ImagePtr& fullImage)
+{
+    const auto& framesRects = m_texturesFramesRects[animationPhase];
+
+    Size size(1);
+    for (const Rect& frameRect : framesRects) {
+        if (frameRect.isValid())
+            size = size.expandedTo(Size(frameRect.right() + 1, frameRect.bottom() + 1));
+    }
+
+    const int bpp = fullImage->getBpp();
+    const ImagePtr image(new Image(size, bpp));
+    image->setTransparentPixel(fullImage->hasTransparentPixel());
+
+    for (uint32_t i = 0; i < framesRects.size(); ++i) {
+        const Rect& frameRect = framesRects[i];
+        if (!frameRect.isValid())
+            continue;
+
+        const Point src = m_texturesFramesOriginRects[animationPhase][i].topLeft() + m_texturesFramesOffsets[animationPhase][i];
+        for (int y = 0; y < frameRect.height(); ++y)
+            memcpy(image->getPixel(frameRect.left(), frameRect.top() + y), fullImage->getPixel(src.x, src.y + y), frameRect.width() * bpp);
+    }
+
+    return image;
 }
 
 Size ThingType::getBestTextureDimension(int w, int h, int count)
@@ -934,6 +1076,11 @@ int ThingType::getExactSize(int layer, int xPattern, int yPattern, int zPattern,
         return 0;
 
     getTexture(animationPhase); // we must calculate it anyway.
+
+    // the frames are not known until the texture is composed
+    if (m_texturesFramesOriginRects[animationPhase].empty())
+        return 0;
+
     const int frameIndex = getTextureIndex(layer, xPattern, yPattern, zPattern);
     const Size size = m_texturesFramesOriginRects[animationPhase][frameIndex].size() - m_texturesFramesOffsets[animationPhase][frameIndex].toSize();
     return std::max<int>(size.width(), size.height());
@@ -945,6 +1092,8 @@ void ThingType::setPathable(bool var)
         m_attribs.remove(ThingAttrNotPathable);
     else
         m_attribs.set(ThingAttrNotPathable, true);
+
+    g_things.updateThingTable(this);
 }
 
 int ThingType::getAnimationPhases()
@@ -965,6 +1114,9 @@ int ThingType::getExactHeight()
         return m_exactHeight;
 
     getTexture(0);
+    if (m_texturesFramesOriginRects[0].empty())
+        return 0;
+
     const int frameIndex = getTextureIndex(0, 0, 0, 0);
     const Size size = m_texturesFramesOriginRects[0][frameIndex].size() - m_texturesFramesOffsets[0][frameIndex].toSize();
 
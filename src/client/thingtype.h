@@ -28,6 +28,7 @@
 #include <framework/core/declarations.h>
 #include <framework/graphics/texture.h>
 #include <framework/graphics/drawpoolmanager.h>
+#include <framework/graphics/textureatlas.h>
 #include <framework/luaengine/luaobject.h>
 #include <framework/net/server.h>
 #include <framework/otml/declarations.h>
@@ -113,6 +114,23 @@ enum ThingAttr : uint8_t
     ThingLastAttr = 255
 };
 
+// bits of the packed flag word ThingTypeManager keeps per thing type,
+// attributes below 56 use their own value and derived properties take the top bits
+enum ThingFlag : uint8_t
+{
+    ThingFlagNotPreWalkable = 56,
+    ThingFlagSingleDimension = 57,
+    ThingFlagTall = 58,
+    ThingFlagWide = 59,
+    ThingFlagLast = 64
+};
+
+inline bool hasThingFlag(uint64_t flags, uint8_t flag)
+{
+    assert(flag < ThingFlagLast);
+    return (flags >> flag) & 1;
+}
+
 struct Imbuement
 {
     int id;
@@ -265,11 +283,22 @@ public:
     bool isNotPreWalkable() { return m_attribs.has(ThingAttrNotPreWalkable); }
     void setPathable(bool var);
     int getExactHeight();
-    TexturePtr getTexture(int animationPhase, TextureType txtType = TextureType::NONE);
+    TexturePtr getTexture(int animationPhase, TextureType txtType = TextureType::NONE) { return getTextureRegion(animationPhase, txtType).texture; }
+    void clearTextures();
+    // drops the textures not drawn since the given time, they are built again when drawn
+    uint32_t evictTextures(ticks_t lastUse);
+
+    // only reads the thing type and the sprites, so it may run on a composer worker
+    ComposedTexturePtr composeTexture(int animationPhase, TextureType txtType);
 
 private:
     bool hasTexture() const { return !m_textures.empty(); }
 
+    // the priority orders the composition of textures not built yet, lower goes first
+    const TextureAtlas::Region& getTextureRegion(int animationPhase, TextureType txtType, uint32_t priority = UINT32_MAX);
+    void layoutTextureFrames(int animationPhase, const std::vector<Rect>& drawRects);
+    ImagePtr cropTextureFrames(int animationPhase, const ImagePtr& fullImage);
+
     static Size getBestTextureDimension(int w, int h, int count);
     uint32_t getSpriteIndex(int w, int h, int l, int x, int y, int z, int a);
     uint32_t getTextureIndex(int l, int x, int y, int z);
@@ -299,7 +328,7 @@ private:
 
     std::vector<int> m_spritesIndex;
 
-    std::vector<TexturePtr> m_textures,
+    std::vector<TextureAtlas::Region> m_textures,
         m_blankTextures,
         m_smoothTextures;
 
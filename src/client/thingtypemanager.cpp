@@ -30,6 +30,7 @@
 #include <framework/core/binarytree.h>
 #include <framework/core/filestream.h>
 #include <framework/core/resourcemanager.h>
+#include <framework/graphics/texturemanager.h>
 #include <framework/otml/otml.h>
 #include <framework/xml/tinyxml.h>
 
@@ -58,17 +59,23 @@ void ThingTypeManager::init()
     m_otbLoaded = false;
     for (auto& m_thingType : m_thingTypes)
         m_thingType.resize(1, m_nullThingType);
+    buildThingTables();
     m_itemTypes.resize(1, m_nullItemType);
+    m_textureComposer.init();
+    g_textures.addEvictor([this](ticks_t lastUse) { return evictTextures(lastUse); });
 }
 
 void ThingTypeManager::terminate()
 {
+    m_textureComposer.terminate();
     for (auto& m_thingType : m_thingTypes)
         m_thingType.clear();
+    buildThingTables();
     m_itemTypes.clear();
     m_reverseItemTypes.clear();
     m_nullThingType = nullptr;
     m_nullItemType = nullptr;
+    m_textureAtlas.clear();
 }
 
 void ThingTypeManager::saveDat(const std::string& fileName)
@@ -109,6 +116,8 @@ bool ThingTypeManager::loadDat(std::string file)
     m_datLoaded = false;
     m_datSignature = 0;
     m_contentRevision = 0;
+    m_textureAtlas.clear();
+    m_textureComposer.clear();
     try {
         file = g_resources.guessFilePath(file, "dat");
 
@@ -138,6 +147,7 @@ bool ThingTypeManager::loadDat(std::string file)
             }
         }
 
+        buildThingTables();
         m_datLoaded = true;
         g_lua.callGlobalField("g_things", "onLoadDat", file);
         return true;
@@ -173,6 +183,7 @@ bool ThingTypeManager::loadOtml(std::string file)
                 if (!type)
                     throw OTMLException(node2, "thing not found");
                 type->unserializeOtml(node2);
+                updateThingTable(type.get());
             }
         }
         return true;
@@ -287,6 +298,8 @@ void ThingTypeManager::loadXml(const std::string& file)
 
 bool ThingTypeManager::loadAppearances(const std::string& file)
 {
+    m_textureAtlas.clear();
+    m_textureComposer.clear();
     try {
         int spritesCount = 0;
         std::string appearancesFile;
@@ -338,6 +351,7 @@ bool ThingTypeManager::loadAppearances(const std::string& file)
                 m_thingTypes[category][id] = type;
             }
         }
+        buildThingTables();
         m_datLoaded = true;
         return true;
     } catch (std::exception& e) {
@@ -346,6 +360,101 @@ bool ThingTypeManager::loadAppearances(const std::string& file)
     }
 }
 
+void ThingTypeManager::buildThingTables()
+{
+    for (int category = -1; ++category < ThingLastCategory;) {
+        const auto& thingTypes = m_thingTypes[category];
+        const size_t size = thingTypes.size();
+
+        ThingTypeTable& table = m_thingTables[category];
+        table.flags.resize(size);
+        table.elevation.resize(size);
+        table.groundSpeed.resize(size);
+        table.minimapColor.resize(size);
+        table.light.resize(size);
+
+        // ids without a type keep the null type's values, which is what getThingType returns for them
+        for (uint16_t id = 0; id < size; ++id)
+            setThingTableEntry(table, id, thingTypes[id].get());
+    }
+}
+
+void ThingTypeManager::setTextureAtlasEnabled(bool enable)
+{
+    if (m_textureAtlasEnabled == enable)
+        return;
+
+    m_textureAtlasEnabled = enable;
+
+    // every texture is built again, into the atlas or on its own
+    for (const auto& thingTypes : m_thingTypes) {
+        for (const auto& thingType : thingTypes)
+            thingType->clearTextures();
+    }
+    m_textureAtlas.clear();
+}
+
+uint32_t ThingTypeManager::evictTextures(ticks_t lastUse)
+{
+    // idle atlas pages go first, so the regions built on them are dropped with the idle textures
+    const uint32_t releasedPages = m_textureAtlas.release(lastUse);
+
+    uint32_t evicted = 0;
+    for (const auto& thingTypes : m_thingTypes) {
+        for (const auto& thingType : thingTypes)
+            evicted += thingType->evictTextures(lastUse);
+    }
+
+    return releasedPages + evicted;
+}
+
+std::map<std::string, double> ThingTypeManager::getTextureAtlasStats()
+{
+    const auto& stats = m_textureAtlas.getStats();
+    const double pageArea = static_cast<double>(m_textureAtlas.getPageSize()) * m_textureAtlas.getPageSize();
+    const size_t pages = m_textureAtlas.getPageCount();
+
+    return {
+        { "enabled", m_textureAtlasEnabled ? 1 : 0 },
+        { "pages", pages },
+        { "maxPages", m_textureAtlas.getMaxPages() },
+        { "pageSize", m_textureAtlas.getPageSize() },
+        { "usage", pages > 0 ? m_textureAtlas.getUsedArea() / (pages * pageArea) : 0 },
+        { "regions", stats.regions },
+        { "evictions", stats.evictions },
+        { "releases", stats.releases },
+        { "rejections", stats.rejections }
+    };
+}
+
+void ThingTypeManager::updateThingTable(ThingType* thingType)
+{
+    const ThingCategory category = thingType->getCategory();
+    const uint16_t id = thingType->getId();
+    if (category < ThingLastCategory && id < m_thingTables[category].flags.size())
+        setThingTableEntry(m_thingTables[category], id, thingType);
+}
+
+void ThingTypeManager::setThingTableEntry(ThingTypeTable& table, uint16_t id, ThingType* thingType)
+{
+    uint64_t flags = 0;
+    for (uint8_t attr = 0; attr < ThingFlagNotPreWalkable; ++attr) {
+        if (thingType->hasAttr(static_cast<ThingAttr>(attr)))
+            flags |= 1ULL << attr;
+    }
+
+    if (thingType->isNotPreWalkable()) flags |= 1ULL << ThingFlagNotPreWalkable;
+    if (thingType->isSingleDimension()) flags |= 1ULL << ThingFlagSingleDimension;
+    if (thingType->getHeight() > 1) flags |= 1ULL << ThingFlagTall;
+    if (thingType->getWidth() > 1) flags |= 1ULL << ThingFlagWide;
+
+    table.flags[id] = flags;
+    table.elevation[id] = thingType->getElevation();
+    table.groundSpeed[id] = thingType->getGroundSpeed();
+    table.minimapColor[id] = thingType->getMinimapColor();
+    table.light[id] = thingType->getLight();
+}
+
 void ThingTypeManager::parseItemType(uint16_t serverId, TiXmlElement* elem)
 {
     ItemTypePtr itemType = nullptr;
@@ -25,9 +25,25 @@
 #include <framework/global.h>
 
 #include "framework/xml/tinyxml.h"
+#include <framework/graphics/textureatlas.h>
 #include "itemtype.h"
+#include "texturecomposer.h"
 #include "thingtype.h"
 
+// thing type data read by tile analysis, pathing and drawing, copied into
+// parallel arrays indexed by id so hot loops don't touch the ThingType objects
+struct ThingTypeTable
+{
+    // what the null thing type reports, its size is undefined and so has an area of one
+    static constexpr uint64_t NULL_THING_FLAGS = 1ULL << ThingFlagSingleDimension;
+
+    std::vector<uint64_t> flags;
+    std::vector<uint16_t> elevation;
+    std::vector<uint16_t> groundSpeed;
+    std::vector<uint8_t> minimapColor;
+    std::vector<Light> light;
+};
+
 class ThingTypeManager
 {
 public:
@@ -70,14 +86,44 @@ public:
     bool isXmlLoaded() { return m_xmlLoaded; }
     bool isOtbLoaded() { return m_otbLoaded; }
 
+    uint64_t getThingFlags(uint16_t id, ThingCategory category) { return category < ThingLastCategory && id < m_thingTables[category].flags.size() ? m_thingTables[category].flags[id] : ThingTypeTable::NULL_THING_FLAGS; }
+    uint16_t getThingElevation(uint16_t id, ThingCategory category) { return category < ThingLastCategory && id < m_thingTables[category].elevation.size() ? m_thingTables[category].elevation[id] : 0; }
+    uint16_t getThingGroundSpeed(uint16_t id, ThingCategory category) { return category < ThingLastCategory && id < m_thingTables[category].groundSpeed.size() ? m_thingTables[category].groundSpeed[id] : 0; }
+    uint8_t getThingMinimapColor(uint16_t id, ThingCategory category) { return category < ThingLastCategory && id < m_thingTables[category].minimapColor.size() ? m_thingTables[category].minimapColor[id] : 0; }
+    Light getThingLight(uint16_t id, ThingCategory category) { return category < ThingLastCategory && id < m_thingTables[category].light.size() ? m_thingTables[category].light[id] : Light(); }
+    void updateThingTable(ThingType* thingType);
+
+    // thing textures are packed into the atlas pages, so draws of different things can be batched
+    TextureAtlas& getTextureAtlas() { return m_textureAtlas; }
+    void setTextureAtlasEnabled(bool enable);
+    bool isTextureAtlasEnabled() { return m_textureAtlasEnabled; }
+    std::map<std::string, double> getTextureAtlasStats();
+    uint32_t evictTextures(ticks_t lastUse);
+    void resetTextureAtlasStats() { m_textureAtlas.resetStats(); }
+
+    // textures of thing types are composed by workers the first time they are drawn
+    TextureComposer& getTextureComposer() { return m_textureComposer; }
+    void setTextureComposerEnabled(bool enable) { m_textureComposer.setEnabled(enable); }
+    bool isTextureComposerEnabled() { return m_textureComposer.isEnabled(); }
+    std::map<std::string, double> getTextureComposerStats() { return m_textureComposer.getStats(); }
+    void resetTextureComposerStats() { m_textureComposer.resetStats(); }
+
     bool isValidDatId(uint16_t id, ThingCategory category) { return id >= 1 && id < m_thingTypes[category].size(); }
     bool isValidOtbId(uint16_t id) { return id >= 1 && id < m_itemTypes.size(); }
 
 private:
+    void buildThingTables();
+    void setThingTableEntry(ThingTypeTable& table, uint16_t id, ThingType* thingType);
+
     ThingTypeList m_thingTypes[ThingLastCategory];
+    ThingTypeTable m_thingTables[ThingLastCategory];
     ItemTypeList m_reverseItemTypes;
     ItemTypeList m_itemTypes;
 
+    TextureAtlas m_textureAtlas{ 2048, 4 };
+    bool m_textureAtlasEnabled{ true };
+    TextureComposer m_textureComposer;
+
     ThingTypePtr m_nullThingType;
     ItemTypePtr m_nullItemType;
 
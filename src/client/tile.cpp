@@ -27,6 +27,7 @@
 #include "lightview.h"
 #include "map.h"
 #include "protocolgame.h"
+#include "thingtypemanager.h"
 #include <framework/core/eventdispatcher.h>
 #include <framework/graphics/drawpoolmanager.h>
 
@@ -239,6 +240,11 @@ void Tile::addThing(const ThingPtr& thing, int stackPos)
 
     m_things.insert(m_things.begin() + stackPos, thing);
 
+    if (thing->isCreature())
+        g_map.indexCreature(thing->static_self_cast<Creature>(), m_position);
+    else if (thing->isItem())
+        g_map.indexItem(thing->static_self_cast<Item>(), m_position);
+
     // get the elevation status before analyze the new item.
     const bool hasElev = hasElevation();
 
@@ -296,6 +302,11 @@ bool Tile::removeThing(const ThingPtr thing)
 
     m_things.erase(it);
 
+    if (thing->isCreature())
+        g_map.unindexCreature(thing->static_self_cast<Creature>(), m_position);
+    else if (thing->isItem())
+        g_map.unindexItem(thing->static_self_cast<Item>(), m_position);
+
     checkForDetachableThing();
 
     thing->onDisappear();
@@ -377,7 +388,7 @@ EffectPtr Tile::getEffect(uint16_t id)
 int Tile::getGroundSpeed()
 {
     if (const ItemPtr& ground = getGround())
-        return ground->getGroundSpeed();
+        return g_things.getThingGroundSpeed(ground->getClientId(), ThingCategoryItem);
 
     return 100;
 }
@@ -391,7 +402,7 @@ uint8_t Tile::getMinimapColorByte()
         if (thing->isCreature() || thing->isCommon())
             continue;
 
-        const uint8_t c = thing->getMinimapColor();
+        const uint8_t c = g_things.getThingMinimapColor(thing->static_self_cast<Item>()->getClientId(), ThingCategoryItem);
         if (c != 0) return c;
     }
 
@@ -714,89 +725,95 @@ bool Tile::checkForDetachableThing()
 void Tile::analyzeThing(const ThingPtr& thing, bool add)
 {
     const int value = add ? 1 : -1;
+    const uint64_t flags = thing->getThingFlags();
+    const auto hasFlag = [flags](uint8_t flag) { return hasThingFlag(flags, flag); };
 
     if (thing->hasLight())
         m_countFlag.hasLight += value;
 
-    if (thing->hasDisplacement())
+    if (hasFlag(ThingAttrDisplacement))
         m_countFlag.hasDisplacement += value;
 
     if (thing->isEffect()) return;
 
-    if (thing->isCommon())
+    const bool isCreature = thing->isCreature();
+    const bool isGroundBorder = hasFlag(ThingAttrGroundBorder);
+    const bool isSingleDimension = hasFlag(ThingFlagSingleDimension);
+
+    if (!hasFlag(ThingAttrGround) && !isGroundBorder && !hasFlag(ThingAttrOnTop) && !isCreature && !hasFlag(ThingAttrOnBottom))
         m_countFlag.hasCommonItem += value;
 
-    if (thing->isOnTop())
+    if (hasFlag(ThingAttrOnTop))
         m_countFlag.hasTopItem += value;
 
-    if (thing->isCreature())
+    if (isCreature)
         m_countFlag.hasCreature += value;
 
-    if (thing->isSingleGroundBorder())
+    if (isGroundBorder && isSingleDimension)
         m_countFlag.hasGroundBorder += value;
 
-    if (thing->isTopGroundBorder())
+    if (isGroundBorder && !isSingleDimension)
         m_countFlag.hasTopGroundBorder += value;
 
-    if (thing->isLyingCorpse() && !g_game.getFeature(Otc::GameMapDontCorrectCorpse))
+    if (hasFlag(ThingAttrLyingCorpse) && !g_game.getFeature(Otc::GameMapDontCorrectCorpse))
         m_countFlag.correctCorpse += value;
 
     // Creatures and items
-    if (thing->isOnBottom()) {
+    if (hasFlag(ThingAttrOnBottom)) {
         m_countFlag.hasBottomItem += value;
 
-        if (thing->isHookSouth())
+        if (hasFlag(ThingAttrHookSouth))
             m_countFlag.hasHookSouth += value;
 
-        if (thing->isHookEast())
+        if (hasFlag(ThingAttrHookEast))
             m_countFlag.hasHookEast += value;
     }
 
     // best option to have something more real, but in some cases as a custom project,
     // the developers are not defining crop size
     //if(thing->getRealSize() > SPRITE_SIZE)
-    if (!thing->isSingleDimension() || thing->hasElevation() || thing->hasDisplacement())
+    if (!isSingleDimension || hasFlag(ThingAttrElevation) || hasFlag(ThingAttrDisplacement))
         m_countFlag.notSingleDimension += value;
 
-    if (thing->getHeight() > 1)
+    if (hasFlag(ThingFlagTall))
         m_countFlag.hasTallThings += value;
 
-    if (thing->getWidth() > 1)
+    if (hasFlag(ThingFlagWide))
         m_countFlag.hasWideThings += value;
 
     if (!thing->isItem()) return;
 
-    if (thing->getHeight() > 1)
+    if (hasFlag(ThingFlagTall))
         m_countFlag.hasTallItems += value;
 
-    if (thing->getWidth() > 1)
+    if (hasFlag(ThingFlagWide))
         m_countFlag.hasWideItems += value;
 
-    if (thing->getWidth() > 1 && thing->getHeight() > 1)
+    if (hasFlag(ThingFlagWide) && hasFlag(ThingFlagTall))
         m_countFlag.hasWall += value;
 
-    if (thing->isNotWalkable())
+    if (hasFlag(ThingAttrNotWalkable))
         m_countFlag.notWalkable += value;
 
-    if (thing->isNotPathable())
+    if (hasFlag(ThingAttrNotPathable))
         m_countFlag.notPathable += value;
 
-    if (thing->blockProjectile())
+    if (hasFlag(ThingAttrBlockProjectile))
         m_countFlag.blockProjectile += value;
 
-    m_totalElevation += thing->getElevation() * value;
+    m_totalElevation += g_things.getThingElevation(thing->static_self_cast<Item>()->getClientId(), ThingCategoryItem) * value;
 
-    if (thing->isFullGround())
+    if (hasFlag(ThingAttrFullGround))
         m_countFlag.fullGround += value;
 
-    if (thing->hasElevation())
+    if (hasFlag(ThingAttrElevation))
         m_countFlag.elevation += value;
 
     if (thing->isOpaque()) {
         m_countFlag.opaque = std::max<int>(m_countFlag.opaque + value, 0);
     }
 
-    if (thing->isGroundBorder() && thing->isNotWalkable())
+    if (isGroundBorder && hasFlag(ThingAttrNotWalkable))
         m_countFlag.hasNoWalkableEdge += value;
 }
 
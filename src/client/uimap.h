@@ -51,6 +51,7 @@ public:
     void setDrawLights(bool enable) { m_mapView->setDrawLights(enable); }
     void setLimitVisibleDimension(bool enable) { m_mapView->setLimitVisibleDimension(enable); updateVisibleDimension(); }
     void setDrawManaBar(bool enable) { m_mapView->setDrawManaBar(enable); }
+    void setIncrementalVisibleTiles(bool enable) { m_mapView->setIncrementalVisibleTiles(enable); }
     void setKeepAspectRatio(bool enable);
     void setMapShader(const PainterShaderProgramPtr& shader, float fadein, float fadeout) { m_mapView->setShader(shader, fadein, fadeout); }
     void setMinimumAmbientLight(float intensity) { m_mapView->setMinimumAmbientLight(intensity); }
@@ -65,6 +66,7 @@ public:
     bool isDrawingLights() { return m_mapView->isDrawingLights(); }
     bool isLimitedVisibleDimension() { return m_mapView->isLimitedVisibleDimension(); }
     bool isDrawingManaBar() { return m_mapView->isDrawingManaBar(); }
+    bool isIncrementalVisibleTiles() { return m_mapView->isIncrementalVisibleTiles(); }
     bool isKeepAspectRatioEnabled() { return m_keepAspectRatio; }
     bool isLimitVisibleRangeEnabled() { return m_limitVisibleRange; }
 
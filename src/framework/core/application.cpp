@@ -74,6 +74,10 @@ void Application::init(std::vector<std::string>& args)
 
     g_asyncDispatcher.init();
 
+#ifdef FRAMEWORK_NET
+    Connection::init();
+#endif
+
     std::string startupOptions;
     for (uint32_t i = 1; i < args.size(); ++i) {
         const auto& arg = args[i];
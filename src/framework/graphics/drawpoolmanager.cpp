@@ -91,6 +91,8 @@ void DrawPoolManager::draw()
 
         pool->clear();
     }
+
+    g_painter->resetDrawStats();
 }
 
 void DrawPoolManager::drawObject(const DrawPool::DrawObject& obj)
@@ -87,3 +87,13 @@ void Graphics::resize(const Size& size)
     m_viewportSize = size;
     g_painter->setResolution(size);
 }
+
+uint32_t Graphics::getDrawCalls()
+{
+    return g_painter->getDrawCalls();
+}
+
+uint32_t Graphics::getTextureChanges()
+{
+    return g_painter->getTextureChanges();
+}
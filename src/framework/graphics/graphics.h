@@ -44,6 +44,9 @@ public:
     std::string getVersion() { return (const char*)glGetString(GL_VERSION); }
     std::string getExtensions() { return (const char*)glGetString(GL_EXTENSIONS); }
 
+    uint32_t getDrawCalls();
+    uint32_t getTextureChanges();
+
     bool ok() { return m_ok; }
 
 private:
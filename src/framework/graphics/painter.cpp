@@ -22,6 +22,7 @@
 
 #include "painter.h"
 
+#include <framework/core/clock.h>
 #include <framework/platform/platformwindow.h>
 #include "framework/graphics/texture.h"
 
@@ -82,6 +83,12 @@ void Painter::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
     if (textured && m_texture->isEmpty())
         return;
 
+    // the texture manager frees cached textures that were not drawn for a while
+    if (textured)
+        m_texture->setLastUse(g_clock.millis());
+
+    ++m_drawCalls;
+
     m_drawProgram = m_shaderProgram ? m_shaderProgram : textured ? m_drawTexturedProgram.get() : m_drawSolidColorProgram.get();
 
     // update shader with the current painter state
@@ -209,6 +216,7 @@ void Painter::setTexture(Texture* texture)
     setTextureMatrix(texture->getTransformMatrix());
     m_glTextureId = texture->getId();
     updateGlTexture();
+    ++m_textureChanges;
 }
 
 void Painter::setAlphaWriting(bool enable)
@@ -109,6 +109,11 @@ public:
     void pushTransformMatrix();
     void popTransformMatrix();
 
+    // draw calls and texture switches of the last frame drawn
+    uint32_t getDrawCalls() { return m_lastDrawCalls; }
+    uint32_t getTextureChanges() { return m_lastTextureChanges; }
+    void resetDrawStats() { m_lastDrawCalls = m_drawCalls; m_lastTextureChanges = m_textureChanges; m_drawCalls = m_textureChanges = 0; }
+
     void resetState();
     void resetBlendEquation() { setBlendEquation(BlendEquation::ADD); }
     void resetTexture() { setTexture(nullptr); }
@@ -140,6 +145,11 @@ protected:
     bool m_alphaWriting{ false };
     uint32_t m_glTextureId{ 0 };
 
+    uint32_t m_drawCalls{ 0 },
+        m_textureChanges{ 0 },
+        m_lastDrawCalls{ 0 },
+        m_lastTextureChanges{ 0 };
+
     float m_opacity{ 1.f };
 
     PainterShaderProgram* m_shaderProgram{ nullptr };
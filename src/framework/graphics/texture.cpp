@@ -27,15 +27,17 @@
 #include <atomic>
 
 #include <framework/core/application.h>
+#include <framework/core/clock.h>
 
 #include "framework/stdext/math.h"
 
  // UINT16_MAX = just to avoid conflicts with GL generated ID.
 static std::atomic<uint32_t > UID(UINT16_MAX);
+static std::atomic<uint64_t> TOTAL_MEMORY_USAGE(0);
 
-Texture::Texture() : m_uniqueId(++UID) {}
+Texture::Texture() : m_uniqueId(++UID), m_lastUse(g_clock.millis()) {}
 
-Texture::Texture(const Size& size) : m_uniqueId(++UID)
+Texture::Texture(const Size& size) : m_uniqueId(++UID), m_lastUse(g_clock.millis())
 {
     m_id = 0;
     m_time = 0;
@@ -50,7 +52,7 @@ Texture::Texture(const Size& size) : m_uniqueId(++UID)
     setupFilters();
 }
 
-Texture::Texture(const ImagePtr& image, bool buildMipmaps, bool compress, bool canSuperimposed, bool load) : m_uniqueId(++UID)
+Texture::Texture(const ImagePtr& image, bool buildMipmaps, bool compress, bool canSuperimposed, bool load) : m_uniqueId(++UID), m_lastUse(g_clock.millis())
 {
     m_id = 0;
     m_time = 0;
@@ -73,6 +75,8 @@ Texture::~Texture()
     // free texture from gl memory
     if (g_graphics.ok() && m_id != 0)
         glDeleteTextures(1, &m_id);
+
+    setMemoryUsage(0);
 }
 
 void Texture::create()
@@ -172,6 +176,8 @@ void Texture::createTexture()
     if (g_graphics.ok() && m_id != 0)
         glDeleteTextures(1, &m_id);
 
+    setMemoryUsage(0);
+
     glGenTextures(1, &m_id);
     assert(m_id != 0);
 }
@@ -261,4 +267,18 @@ void Texture::setupPixels(int level, const Size& size, uint8_t* pixels, int chan
 #endif
 
     glTexImage2D(GL_TEXTURE_2D, level, internalFormat, size.width(), size.height(), 0, format, GL_UNSIGNED_BYTE, pixels);
+
+    // the base level replaces the whole texture, mipmaps are added to it,
+    // compressed textures are counted as if they were not
+    const uint64_t bytes = static_cast<uint64_t>(size.area()) * 4;
+    setMemoryUsage(level == 0 ? bytes : m_memoryUsage + bytes);
 }
+
+void Texture::setMemoryUsage(uint64_t bytes)
+{
+    TOTAL_MEMORY_USAGE -= m_memoryUsage;
+    TOTAL_MEMORY_USAGE += bytes;
+    m_memoryUsage = bytes;
+}
+
+uint64_t Texture::getTotalMemoryUsage() { return TOTAL_MEMORY_USAGE; }
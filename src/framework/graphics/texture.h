@@ -42,10 +42,13 @@ public:
     virtual void setRepeat(bool repeat);
     void setUpsideDown(bool upsideDown);
     void setTime(ticks_t time) { m_time = time; }
+    void setLastUse(ticks_t time) { m_lastUse = time; }
 
     uint32_t getId() { return m_id; }
     uint32_t getUniqueId() const { return m_uniqueId; }
     ticks_t getTime() { return m_time; }
+    ticks_t getLastUse() { return m_lastUse; }
+    uint64_t getMemoryUsage() { return m_memoryUsage; }
     int getWidth() { return m_size.width(); }
     int getHeight() { return m_size.height(); }
     const Size& getSize() { return m_size; }
@@ -58,7 +61,10 @@ public:
     bool isOpaque() const { return m_opaque; }
     bool canSuperimposed() const { return m_canSuperimposed; }
 
-    void create();
+    virtual void create();
+
+    // bytes of video memory held by all textures
+    static uint64_t getTotalMemoryUsage();
 
 protected:
     void createTexture();
@@ -67,11 +73,14 @@ protected:
     void setupFilters();
     void setupTranformMatrix();
     void setupPixels(int level, const Size& size, uint8_t* pixels, int channels = 4, bool compress = false);
+    void setMemoryUsage(uint64_t bytes);
 
     const uint32_t m_uniqueId;
 
     uint32_t m_id{ 0 };
     ticks_t m_time{ 0 };
+    ticks_t m_lastUse{ 0 };
+    uint64_t m_memoryUsage{ 0 };
     Size m_size, m_glSize;
 
     Matrix3 m_transformMatrix;
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "textureatlas.h"
+#include "graphics.h"
+#include "image.h"
+
+// transparent border around each packed image, so filtering never picks up a neighbor
+static constexpr int PADDING = 1;
+
+void TextureAtlas::PageTexture::create()
+{
+    if (m_id == 0) {
+        createTexture();
+        bind();
+        setupPixels(0, m_glSize, nullptr, 4);
+        setupWrap();
+        setupFilters();
+    } else if (!m_uploads.empty())
+        bind();
+
+    for (const auto& [pos, image] : m_uploads)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, pos.x, pos.y, image->getWidth(), image->getHeight(), GL_RGBA, GL_UNSIGNED_BYTE, image->getPixelData());
+
+    m_uploads.clear();
+}
+
+bool TextureAtlas::add(const ImagePtr& image, Region& region)
+{
+    if (m_pages.empty() && g_graphics.getMaxTextureSize() > 0)
+        m_pageSize = std::min<int>(m_pageSize, g_graphics.getMaxTextureSize());
+
+    const Size size = image->getSize() + Size(PADDING * 2);
+    if (image->getBpp() != 4 || size.width() > m_pageSize / MAX_IMAGE_SIZE_DIVISOR || size.height() > m_pageSize / MAX_IMAGE_SIZE_DIVISOR) {
+        ++m_stats.rejections;
+        return false;
+    }
+
+    Point pos;
+    Page* page = nullptr;
+    for (auto& candidate : m_pages) {
+        if (candidate.texture && insert(candidate, size, pos)) {
+            page = &candidate;
+            break;
+        }
+    }
+
+    if (!page) {
+        page = allocatePage();
+        if (!page || !insert(*page, size, pos)) {
+            ++m_stats.rejections;
+            return false;
+        }
+    }
+
+    const ImagePtr paddedImage(new Image(size));
+    const int rowSize = image->getWidth() * 4;
+    for (int y = 0; y < image->getHeight(); ++y)
+        memcpy(paddedImage->getPixel(PADDING, y + PADDING), image->getPixel(0, y), rowSize);
+
+    page->texture->upload(pos, paddedImage);
+    page->lastUse = g_clock.millis();
+    ++m_stats.regions;
+
+    region.texture = page->texture;
+    region.offset = pos + Point(PADDING);
+    region.page = static_cast<uint16_t>(page - m_pages.data());
+    region.generation = page->generation;
+    return true;
+}
+
+void TextureAtlas::clear()
+{
+    // pages are dropped with a new generation, so no region outlives them
+    m_pages.clear();
+    ++m_generation;
+}
+
+uint32_t TextureAtlas::release(ticks_t lastUse)
+{
+    uint32_t released = 0;
+    for (auto& page : m_pages) {
+        if (!page.texture || page.lastUse >= lastUse)
+            continue;
+
+        // the texture lives on until the regions built on it are dropped
+        page.texture = nullptr;
+        page.skyline.clear();
+        page.usedArea = 0;
+        page.generation = ++m_generation;
+        ++released;
+    }
+
+    m_stats.releases += released;
+    return released;
+}
+
+size_t TextureAtlas::getPageCount()
+{
+    return std::count_if(m_pages.begin(), m_pages.end(), [](const Page& page) { return page.texture != nullptr; });
+}
+
+uint64_t TextureAtlas::getUsedArea()
+{
+    uint64_t area = 0;
+    for (const auto& page : m_pages)
+        area += page.usedArea;
+    return area;
+}
+
+TextureAtlas::Page* TextureAtlas::allocatePage()
+{
+    for (auto& page : m_pages) {
+        if (!page.texture) {
+            page.texture = stdext::shared_object_ptr<PageTexture>(new PageTexture(Size(m_pageSize)));
+            resetPage(page);
+            return &page;
+        }
+    }
+
+    if (m_pages.size() < m_maxPages) {
+        auto& page = m_pages.emplace_back();
+        page.texture = stdext::shared_object_ptr<PageTexture>(new PageTexture(Size(m_pageSize)));
+        resetPage(page);
+        return &page;
+    }
+
+    // the least recently drawn page is emptied, unless its regions are still being drawn
+    const auto it = std::min_element(m_pages.begin(), m_pages.end(), [](const Page& a, const Page& b) { return a.lastUse < b.lastUse; });
+    if (g_clock.millis() - it->lastUse < EVICTION_IDLE_TIME)
+        return nullptr;
+
+    resetPage(*it);
+    ++m_stats.evictions;
+    return &*it;
+}
+
+void TextureAtlas::resetPage(Page& page)
+{
+    page.texture->clearUploads();
+    page.skyline = { { 0, 0, m_pageSize } };
+    page.usedArea = 0;
+    page.generation = ++m_generation;
+    page.lastUse = g_clock.millis();
+}
+
+bool TextureAtlas::insert(Page& page, const Size& size, Point& pos)
+{
+    auto& skyline = page.skyline;
+
+    // bottom left rule, the position that keeps the skyline lowest wins
+    int bestIndex = -1, bestBottom = INT_MAX, bestWidth = INT_MAX;
+    for (size_t i = 0; i < skyline.size(); ++i) {
+        const int x = skyline[i].x;
+        if (x + size.width() > m_pageSize)
+            break;
+
+        int y = 0;
+        for (size_t j = i, width = 0; j < skyline.size() && width < static_cast<size_t>(size.width()); width += skyline[j++].width)
+            y = std::max<int>(y, skyline[j].y);
+
+        const int bottom = y + size.height();
+        if (bottom > m_pageSize)
+            continue;
+
+        if (bottom < bestBottom || (bottom == bestBottom && skyline[i].width < bestWidth)) {
+            bestIndex = static_cast<int>(i);
+            bestBottom = bottom;
+            bestWidth = skyline[i].width;
+            pos = { x, y };
+        }
+    }
+
+    if (bestIndex < 0)
+        return false;
+
+    // the image becomes a node of the skyline, hiding what it covers of the nodes after it
+    skyline.insert(skyline.begin() + bestIndex, { pos.x, bestBottom, size.width() });
+    const int right = pos.x + size.width();
+    for (size_t i = bestIndex + 1; i < skyline.size();) {
+        auto& node = skyline[i];
+        if (node.x >= right)
+            break;
+
+        const int covered = right - node.x;
+        if (node.width <= covered) {
+            skyline.erase(skyline.begin() + i);
+            continue;
+        }
+
+        node.x += covered;
+        node.width -= covered;
+        break;
+    }
+
+    for (size_t i = 0; i + 1 < skyline.size();) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        } else
+            ++i;
+    }
+
+    page.usedArea += size.area();
+    return true;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "texture.h"
+#include <framework/core/clock.h>
+
+// packs images into a few large pages, images packed on the same page share
+// one texture, so the draw pool can batch their draws together
+class TextureAtlas
+{
+public:
+    // images bigger than a fraction of a page would leave too little room for the others
+    static constexpr int MAX_IMAGE_SIZE_DIVISOR = 2;
+    // a page is only emptied for new images when nothing was drawn from it for a while
+    static constexpr ticks_t EVICTION_IDLE_TIME = 1000;
+
+    // where an image was packed, it stays valid until its page is evicted
+    struct Region
+    {
+        TexturePtr texture;
+        Point offset;
+        uint16_t page{ UINT16_MAX };
+        uint32_t generation{ 0 };
+    };
+
+    struct Stats
+    {
+        uint32_t regions{ 0 },
+            evictions{ 0 },
+            releases{ 0 },
+            rejections{ 0 };
+    };
+
+    TextureAtlas(int pageSize, uint16_t maxPages) : m_pageSize(pageSize), m_maxPages(maxPages) {}
+
+    bool add(const ImagePtr& image, Region& region);
+    void clear();
+    // frees the pages last drawn from before the given time, their regions are no longer valid
+    uint32_t release(ticks_t lastUse);
+
+    // regions not packed into a page, like standalone textures, are always valid
+    bool isValid(const Region& region) { return region.page == UINT16_MAX || (region.page < m_pages.size() && m_pages[region.page].generation == region.generation); }
+    void use(const Region& region) { if (region.page < m_pages.size()) m_pages[region.page].lastUse = g_clock.millis(); }
+
+    int getPageSize() { return m_pageSize; }
+    uint16_t getMaxPages() { return m_maxPages; }
+    size_t getPageCount();
+    uint64_t getUsedArea();
+    const Stats& getStats() { return m_stats; }
+    void resetStats() { m_stats = {}; }
+
+private:
+    class PageTexture : public Texture
+    {
+    public:
+        PageTexture(const Size& size) { setupSize(size); }
+
+        void create() override;
+
+        void upload(const Point& pos, const ImagePtr& image) { m_uploads.emplace_back(pos, image); }
+        void clearUploads() { m_uploads.clear(); }
+
+    private:
+        std::vector<std::pair<Point, ImagePtr>> m_uploads;
+    };
+
+    // top edge of the packed images, from left to right across the page
+    struct SkylineNode
+    {
+        int x, y, width;
+    };
+
+    struct Page
+    {
+        stdext::shared_object_ptr<PageTexture> texture;
+        std::vector<SkylineNode> skyline;
+        uint64_t usedArea{ 0 };
+        uint32_t generation{ 0 };
+        ticks_t lastUse{ 0 };
+    };
+
+    Page* allocatePage();
+    void resetPage(Page& page);
+    bool insert(Page& page, const Size& size, Point& pos);
+
+    std::vector<Page> m_pages;
+    Stats m_stats;
+
+    int m_pageSize;
+    uint16_t m_maxPages;
+    uint32_t m_generation{ 0 };
+};
@@ -45,6 +45,7 @@ void TextureManager::terminate()
     }
     m_textures.clear();
     m_animatedTextures.clear();
+    m_evictors.clear();
     m_emptyTexture = nullptr;
 }
 
@@ -59,6 +60,67 @@ void TextureManager::poll()
 
     for (const AnimatedTexturePtr& animatedTexture : m_animatedTextures)
         animatedTexture->updateAnimation();
+
+    if (now - m_lastEviction >= EVICTION_INTERVAL) {
+        m_lastEviction = now;
+        evictTextures();
+    }
+}
+
+void TextureManager::evictTextures()
+{
+    const ticks_t now = g_clock.millis();
+
+    // idle textures are always freed, over the budget the idle time is halved until the usage fits,
+    // this frees the least recently drawn textures first without keeping them all in one list
+    ticks_t idleTime = m_idleTime;
+    while (true) {
+        m_evictions += evictIdleTextures(now - idleTime);
+        if (m_memoryBudget == 0 || getMemoryUsage() <= m_memoryBudget || idleTime <= MIN_IDLE_TIME)
+            break;
+
+        idleTime = std::max<ticks_t>(idleTime / 2, MIN_IDLE_TIME);
+    }
+}
+
+uint32_t TextureManager::evictIdleTextures(ticks_t lastUse)
+{
+    uint32_t evicted = evictCachedTextures(lastUse);
+    for (const auto& evictor : m_evictors)
+        evicted += evictor(lastUse);
+    return evicted;
+}
+
+uint32_t TextureManager::evictCachedTextures(ticks_t lastUse)
+{
+    std::vector<std::string> evicted;
+    for (const auto& [filePath, texture] : m_textures) {
+        // textures still held elsewhere, like by widgets, stay cached
+        const refcount_t refs = texture->isAnimatedTexture() ? 2 : 1;
+        if (texture->ref_count() > refs || texture->getLastUse() >= lastUse)
+            continue;
+
+        if (texture->isAnimatedTexture())
+            std::erase_if(m_animatedTextures, [&](const AnimatedTexturePtr& animatedTexture) { return animatedTexture.get() == texture.get(); });
+
+        evicted.emplace_back(filePath);
+    }
+
+    for (const auto& filePath : evicted)
+        m_textures.erase(filePath);
+
+    return evicted.size();
+}
+
+std::map<std::string, double> TextureManager::getMemoryStats()
+{
+    return {
+        { "usage", getMemoryUsage() },
+        { "budget", m_memoryBudget },
+        { "idleTime", m_idleTime },
+        { "cachedTextures", m_textures.size() },
+        { "evictions", m_evictions }
+    };
 }
 
 void TextureManager::clearCache()
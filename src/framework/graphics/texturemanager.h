@@ -28,6 +28,15 @@
 class TextureManager
 {
 public:
+    // how often textures are checked for eviction
+    static constexpr ticks_t EVICTION_INTERVAL = 1000;
+    // over the memory budget, textures drawn more recently than this are still kept
+    static constexpr ticks_t MIN_IDLE_TIME = 5000;
+
+    // frees the textures last drawn before the given time, returns how many were freed,
+    // whoever owns them must create them again when they are needed
+    using Evictor = std::function<uint32_t(ticks_t lastUse)>;
+
     void init();
     void terminate();
     void poll();
@@ -39,13 +48,33 @@ public:
     TexturePtr getTexture(const std::string& fileName);
     const TexturePtr& getEmptyTexture() { return m_emptyTexture; }
 
+    void addEvictor(const Evictor& evictor) { m_evictors.emplace_back(evictor); }
+    void evictTextures();
+
+    void setIdleTime(ticks_t time) { m_idleTime = std::max<ticks_t>(time, MIN_IDLE_TIME); }
+    ticks_t getIdleTime() { return m_idleTime; }
+    void setMemoryBudget(uint64_t bytes) { m_memoryBudget = bytes; }
+    uint64_t getMemoryBudget() { return m_memoryBudget; }
+    uint64_t getMemoryUsage() { return Texture::getTotalMemoryUsage(); }
+    std::map<std::string, double> getMemoryStats();
+    void resetMemoryStats() { m_evictions = 0; }
+
 private:
     TexturePtr loadTexture(std::stringstream& file);
+    uint32_t evictIdleTextures(ticks_t lastUse);
+    uint32_t evictCachedTextures(ticks_t lastUse);
 
     stdext::map<std::string, TexturePtr> m_textures;
     std::vector<AnimatedTexturePtr> m_animatedTextures;
     TexturePtr m_emptyTexture;
     ScheduledEventPtr m_liveReloadEvent;
+
+    std::vector<Evictor> m_evictors;
+    ticks_t m_idleTime{ 60000 };
+    ticks_t m_lastEviction{ 0 };
+    // 0 is no budget, textures are only freed for being idle
+    uint64_t m_memoryBudget{ 0 };
+    uint64_t m_evictions{ 0 };
 };
 
 extern TextureManager g_textures;
@@ -51,6 +51,7 @@
 #endif
 
 #ifdef FRAMEWORK_NET
+#include <framework/net/packetrecorder.h>
 #include <framework/net/protocol.h>
 #include <framework/net/protocolhttp.h>
 #include <framework/net/server.h>
@@ -303,12 +304,22 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_graphics", "getVendor", &Graphics::getVendor, &g_graphics);
     g_lua.bindSingletonFunction("g_graphics", "getRenderer", &Graphics::getRenderer, &g_graphics);
     g_lua.bindSingletonFunction("g_graphics", "getVersion", &Graphics::getVersion, &g_graphics);
+    g_lua.bindSingletonFunction("g_graphics", "getDrawCalls", &Graphics::getDrawCalls, &g_graphics);
+    g_lua.bindSingletonFunction("g_graphics", "getTextureChanges", &Graphics::getTextureChanges, &g_graphics);
 
     // Textures
     g_lua.registerSingletonClass("g_textures");
     g_lua.bindSingletonFunction("g_textures", "preload", &TextureManager::preload, &g_textures);
     g_lua.bindSingletonFunction("g_textures", "clearCache", &TextureManager::clearCache, &g_textures);
     g_lua.bindSingletonFunction("g_textures", "liveReload", &TextureManager::liveReload, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "evictTextures", &TextureManager::evictTextures, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "setIdleTime", &TextureManager::setIdleTime, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getIdleTime", &TextureManager::getIdleTime, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "setMemoryBudget", &TextureManager::setMemoryBudget, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getMemoryBudget", &TextureManager::getMemoryBudget, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getMemoryUsage", &TextureManager::getMemoryUsage, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getMemoryStats", &TextureManager::getMemoryStats, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "resetMemoryStats", &TextureManager::resetMemoryStats, &g_textures);
 
     // UI
     g_lua.registerSingletonClass("g_ui");
@@ -765,6 +776,30 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<Protocol>("generateXteaKey", &Protocol::generateXteaKey);
     g_lua.bindClassMemberFunction<Protocol>("enableXteaEncryption", &Protocol::enableXteaEncryption);
     g_lua.bindClassMemberFunction<Protocol>("enableChecksum", &Protocol::enableChecksum);
+    g_lua.bindClassMemberFunction<Protocol>("enableCompression", &Protocol::enableCompression);
+    g_lua.bindClassMemberFunction<Protocol>("setOutboundCompression", &Protocol::setOutboundCompression);
+    g_lua.bindClassMemberFunction<Protocol>("enableCoalescedRecv", &Protocol::enableCoalescedRecv);
+    g_lua.bindClassMemberFunction<Protocol>("setRecorder", &Protocol::setRecorder);
+    g_lua.bindClassMemberFunction<Protocol>("getRecorder", &Protocol::getRecorder);
+
+    // PacketRecorder
+    g_lua.registerClass<PacketRecorder>();
+    g_lua.bindClassStaticFunction<PacketRecorder>("create", &PacketRecorder::create);
+    g_lua.bindClassMemberFunction<PacketRecorder>("close", &PacketRecorder::close);
+    g_lua.bindClassMemberFunction<PacketRecorder>("isRecording", &PacketRecorder::isRecording);
+    g_lua.bindClassMemberFunction<PacketRecorder>("getPacketCount", &PacketRecorder::getPacketCount);
+
+    // PacketPlayer
+    g_lua.registerClass<PacketPlayer>();
+    g_lua.bindClassStaticFunction<PacketPlayer>("create", &PacketPlayer::create);
+    g_lua.bindClassMemberFunction<PacketPlayer>("start", &PacketPlayer::start);
+    g_lua.bindClassMemberFunction<PacketPlayer>("stop", &PacketPlayer::stop);
+    g_lua.bindClassMemberFunction<PacketPlayer>("benchmark", &PacketPlayer::benchmark);
+    g_lua.bindClassMemberFunction<PacketPlayer>("isPlaying", &PacketPlayer::isPlaying);
+    g_lua.bindClassMemberFunction<PacketPlayer>("getClientVersion", &PacketPlayer::getClientVersion);
+    g_lua.bindClassMemberFunction<PacketPlayer>("getPacketCount", &PacketPlayer::getPacketCount);
+    g_lua.bindClassMemberFunction<PacketPlayer>("getPosition", &PacketPlayer::getPosition);
+    g_lua.bindClassMemberFunction<PacketPlayer>("getDuration", &PacketPlayer::getDuration);
 
     // ProtocolHttp
     g_lua.registerClass<ProtocolHttp>();
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "compression.h"
+
+#include <zlib.h>
+
+namespace
+{
+    // negative window bits select raw deflate, without zlib header and trailer
+    constexpr int WINDOW_BITS = -15;
+    constexpr size_t CHUNK_SIZE = 16384;
+}
+
+InflateStream::InflateStream() : m_stream(std::make_unique<z_stream>())
+{
+    if (inflateInit2(m_stream.get(), WINDOW_BITS) != Z_OK) {
+        g_logger.error("Unable to initialize inflate stream");
+        m_failed = true;
+    }
+}
+
+InflateStream::~InflateStream()
+{
+    if (!m_failed)
+        inflateEnd(m_stream.get());
+}
+
+bool InflateStream::inflate(const uint8_t* data, size_t size, size_t maxSize)
+{
+    // once the stream is broken the following messages can't be decoded either
+    if (m_failed)
+        return false;
+
+    m_output.clear();
+    m_stream->next_in = const_cast<uint8_t*>(data);
+    m_stream->avail_in = static_cast<uInt>(size);
+
+    do {
+        const size_t used = m_output.size();
+        if (used >= maxSize) {
+            g_logger.traceError("inflated network message is too large");
+            return false;
+        }
+
+        m_output.resize(std::min(used + CHUNK_SIZE, maxSize));
+        m_stream->next_out = m_output.data() + used;
+        m_stream->avail_out = static_cast<uInt>(m_output.size() - used);
+
+        const int ret = ::inflate(m_stream.get(), Z_SYNC_FLUSH);
+        if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            g_logger.traceError(stdext::format("failed to inflate network message: %s", m_stream->msg ? m_stream->msg : "unknown error"));
+            m_failed = true;
+            return false;
+        }
+        m_output.resize(m_output.size() - m_stream->avail_out);
+    } while (m_stream->avail_in > 0 || m_stream->avail_out == 0);
+
+    return true;
+}
+
+DeflateStream::DeflateStream(int level) : m_stream(std::make_unique<z_stream>())
+{
+    if (deflateInit2(m_stream.get(), level, Z_DEFLATED, WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        g_logger.error("Unable to initialize deflate stream");
+        m_failed = true;
+    }
+}
+
+DeflateStream::~DeflateStream()
+{
+    if (!m_failed)
+        deflateEnd(m_stream.get());
+}
+
+bool DeflateStream::deflate(const uint8_t* data, size_t size, size_t reserved)
+{
+    if (m_failed)
+        return false;
+
+    m_output.resize(reserved);
+    m_stream->next_in = const_cast<uint8_t*>(data);
+    m_stream->avail_in = static_cast<uInt>(size);
+
+    // a sync flush ends every message on a byte boundary, so it can be inflated on its own
+    do {
+        const size_t used = m_output.size();
+        m_output.resize(used + std::max<size_t>(deflateBound(m_stream.get(), m_stream->avail_in), 64));
+        m_stream->next_out = m_output.data() + used;
+        m_stream->avail_out = static_cast<uInt>(m_output.size() - used);
+
+        if (::deflate(m_stream.get(), Z_SYNC_FLUSH) == Z_STREAM_ERROR) {
+            g_logger.traceError("failed to deflate network message");
+            m_failed = true;
+            return false;
+        }
+        m_output.resize(m_output.size() - m_stream->avail_out);
+    } while (m_stream->avail_out == 0);
+
+    return true;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <framework/global.h>
+
+struct z_stream_s;
+
+// raw deflate streams that live as long as the connection, so every message
+// is compressed against the history of the previous ones instead of from scratch
+
+class InflateStream
+{
+public:
+    InflateStream();
+    ~InflateStream();
+
+    InflateStream(const InflateStream&) = delete;
+    InflateStream& operator=(const InflateStream&) = delete;
+
+    // output is only valid until the next call
+    bool inflate(const uint8_t* data, size_t size, size_t maxSize);
+    const std::vector<uint8_t>& getOutput() { return m_output; }
+
+private:
+    std::unique_ptr<z_stream_s> m_stream;
+    std::vector<uint8_t> m_output;
+    bool m_failed{ false };
+};
+
+class DeflateStream
+{
+public:
+    DeflateStream(int level = 6);
+    ~DeflateStream();
+
+    DeflateStream(const DeflateStream&) = delete;
+    DeflateStream& operator=(const DeflateStream&) = delete;
+
+    // the compressed data follows reserved bytes left for the caller to fill
+    bool deflate(const uint8_t* data, size_t size, size_t reserved);
+    std::vector<uint8_t>& getOutput() { return m_output; }
+
+private:
+    std::unique_ptr<z_stream_s> m_stream;
+    std::vector<uint8_t> m_output;
+    bool m_failed{ false };
+};
@@ -28,8 +28,26 @@
 #include <asio/read.hpp>
 #include <asio/read_until.hpp>
 
+#ifdef NETWORK_THREAD
+#include <asio/executor_work_guard.hpp>
+#include <asio/post.hpp>
+#include <mutex>
+#include <optional>
+#include <thread>
+#endif
+
 asio::io_service g_ioService;
-std::list<std::shared_ptr<asio::streambuf>> Connection::m_outputStreams;
+
+#ifdef NETWORK_THREAD
+namespace
+{
+    std::thread s_networkThread;
+    std::optional<asio::executor_work_guard<asio::io_service::executor_type>> s_networkWork;
+
+    std::mutex s_mainEventsMutex;
+    std::vector<std::function<void()>> s_mainEvents;
+}
+#endif
 
 Connection::Connection() :
     m_readTimer(g_ioService),
@@ -44,36 +62,95 @@ Connection::~Connection()
 #ifndef NDEBUG
     assert(!g_app.isTerminated());
 #endif
-    close();
+    // nothing else references this connection anymore, so it is safe to release the socket from any thread
+    internal_close();
+}
+
+void Connection::init()
+{
+#ifdef NETWORK_THREAD
+    // all socket operations, framing and decryption run on this thread, the main thread
+    // only receives ready to use results through Connection::poll
+    s_networkWork.emplace(asio::make_work_guard(g_ioService));
+    s_networkThread = std::thread([] { g_ioService.run(); });
+#endif
 }
 
 void Connection::poll()
 {
+#ifdef NETWORK_THREAD
+    std::vector<std::function<void()>> events;
+    {
+        std::scoped_lock lock(s_mainEventsMutex);
+        events.swap(s_mainEvents);
+    }
+
+    for (const auto& event : events)
+        event();
+#else
     // reset must always be called prior to poll
     g_ioService.reset();
     g_ioService.poll();
+#endif
 }
 
 void Connection::terminate()
 {
     g_ioService.stop();
-    m_outputStreams.clear();
+#ifdef NETWORK_THREAD
+    s_networkWork.reset();
+    if (s_networkThread.joinable())
+        s_networkThread.join();
+
+    std::scoped_lock lock(s_mainEventsMutex);
+    s_mainEvents.clear();
+#endif
+    OutputMessage::clearBufferPool();
+}
+
+#ifdef NETWORK_THREAD
+void Connection::postToMain(std::function<void()>&& callback)
+{
+    std::scoped_lock lock(s_mainEventsMutex);
+    s_mainEvents.emplace_back(std::move(callback));
 }
 
+bool Connection::isNetworkThread() { return std::this_thread::get_id() == s_networkThread.get_id(); }
+#endif
+
 void Connection::close()
+{
+    if (!m_connected && !m_connecting)
+        return;
+
+    m_connectCallback = nullptr;
+    m_errorCallback = nullptr;
+    m_recvCallback = nullptr;
+
+#ifdef NETWORK_THREAD
+    if (!isNetworkThread()) {
+        asio::post(g_ioService, [self = asConnection()] { self->internal_close(); });
+        return;
+    }
+#endif
+
+    internal_close();
+}
+
+void Connection::internal_close()
 {
     if (!m_connected && !m_connecting)
         return;
 
     // flush send data before disconnecting on clean connections
-    if (m_connected && !m_error && m_outputStream)
+    if (m_connected && !m_error && !m_pendingWrites.empty())
         internal_write();
 
     m_connecting = false;
     m_connected = false;
-    m_connectCallback = nullptr;
-    m_errorCallback = nullptr;
-    m_recvCallback = nullptr;
+#ifdef NETWORK_THREAD
+    m_networkRecvCallback = nullptr;
+#endif
 
     m_resolver.cancel();
     m_readTimer.cancel();
@@ -94,7 +171,16 @@ void Connection::connect(const std::string_view host, uint16_t port, const std::
     m_error.clear();
     m_connectCallback = connectCallback;
 
-    const asio::ip::tcp::resolver::query query(host.data(), stdext::unsafe_cast<std::string>(port));
+#ifdef NETWORK_THREAD
+    asio::post(g_ioService, [self = asConnection(), host = std::string{ host }, port] { self->internal_resolve(host, port); });
+#else
+    internal_resolve(std::string{ host }, port);
+#endif
+}
+
+void Connection::internal_resolve(const std::string& host, uint16_t port)
+{
+    const asio::ip::tcp::resolver::query query(host, stdext::unsafe_cast<std::string>(port));
     m_resolver.async_resolve(query, [capture0 = asConnection()](auto&& PH1, auto&& PH2) {
         capture0->onResolve(std::forward<decltype(PH1)>(PH1),
                             std::forward<decltype(PH2)>(PH2));
@@ -125,38 +211,62 @@ void Connection::write(uint8_t* buffer, size_t size)
     if (!m_connected)
         return;
 
-    // we can't send the data right away, otherwise we could create tcp congestion
-    if (!m_outputStream) {
-        if (!m_outputStreams.empty()) {
-            m_outputStream = m_outputStreams.front();
-            m_outputStreams.pop_front();
-        } else
-            m_outputStream = std::make_shared<asio::streambuf>();
+    // copied into pooled buffers, in chunks when larger than a single one
+    while (size > 0) {
+        const auto chunk = static_cast<uint16_t>(std::min<size_t>(size, UINT16_MAX));
+        auto outputBuffer = OutputMessage::acquireBuffer();
+        memcpy(outputBuffer->data(), buffer, chunk);
+        write(std::move(outputBuffer), 0, chunk);
 
+        buffer += chunk;
+        size -= chunk;
+    }
+}
+
+void Connection::write(OutputMessage::BufferPtr&& buffer, uint16_t offset, uint16_t size)
+{
+    if (!m_connected) {
+        OutputMessage::releaseBuffer(std::move(buffer));
+        return;
+    }
+
+#ifdef NETWORK_THREAD
+    if (!isNetworkThread()) {
+        asio::post(g_ioService, [self = asConnection(), buffer = std::move(buffer), offset, size]() mutable {
+            self->write(std::move(buffer), offset, size);
+        });
+        return;
+    }
+#endif
+
+    m_pendingWrites.push_back({ std::move(buffer), offset, size });
+
+    // we can't send the data right away, otherwise we could create tcp congestion,
+    // everything queued until then goes out together, after the write in flight
+    if (m_pendingWrites.size() == 1 && !m_writing) {
         m_delayedWriteTimer.cancel();
         m_delayedWriteTimer.expires_from_now(asio::chrono::milliseconds(0));
         m_delayedWriteTimer.async_wait([capture0 = asConnection()](auto&& PH1) {
             capture0->onCanWrite(std::forward<decltype(PH1)>(PH1));
         });
     }
-
-    std::ostream os(m_outputStream.get());
-    os.write((const char*)buffer, size);
-    os.flush();
 }
 
 void Connection::internal_write()
 {
-    if (!m_connected)
+    if (!m_connected || m_writing || m_pendingWrites.empty())
         return;
 
-    std::shared_ptr<asio::streambuf> outputStream = m_outputStream;
-    m_outputStream = nullptr;
+    m_activeWrites.swap(m_pendingWrites);
 
-    async_write(m_socket,
-                *outputStream,
-                [capture0 = asConnection(), outputStream](auto&& PH1, auto&& PH2) {
-        capture0->onWrite(std::forward<decltype(PH1)>(PH1), std::forward<decltype(PH2)>(PH2), outputStream);
+    std::vector<asio::const_buffer> buffers;
+    buffers.reserve(m_activeWrites.size());
+    for (const auto& pending : m_activeWrites)
+        buffers.emplace_back(pending.buffer->data() + pending.offset, pending.size);
+
+    m_writing = true;
+    asio::async_write(m_socket, buffers, [capture0 = asConnection()](auto&& PH1, auto&& PH2) {
+        capture0->onWrite(std::forward<decltype(PH1)>(PH1), std::forward<decltype(PH2)>(PH2));
     });
 
     m_writeTimer.cancel();
@@ -173,6 +283,27 @@ void Connection::read(uint16_t bytes, const RecvCallback& callback)
 
     m_recvCallback = callback;
 
+#ifdef NETWORK_THREAD
+    asio::post(g_ioService, [self = asConnection(), bytes] { self->internal_read(bytes); });
+#else
+    internal_read(bytes);
+#endif
+}
+
+#ifdef NETWORK_THREAD
+void Connection::readOnNetworkThread(uint16_t bytes, const RecvCallback& callback)
+{
+    assert(isNetworkThread());
+    if (!m_connected)
+        return;
+
+    m_networkRecvCallback = callback;
+    internal_read(bytes);
+}
+#endif
+
+void Connection::internal_read(uint16_t bytes)
+{
     async_read(m_socket,
                m_inputStream.prepare(bytes),
                [capture0 = asConnection()](auto&& PH1, auto&& PH2) {
@@ -193,6 +324,15 @@ void Connection::read_until(const std::string_view what, const RecvCallback& cal
 
     m_recvCallback = callback;
 
+#ifdef NETWORK_THREAD
+    asio::post(g_ioService, [self = asConnection(), what = std::string{ what }] { self->internal_read_until(what); });
+#else
+    internal_read_until(std::string{ what });
+#endif
+}
+
+void Connection::internal_read_until(const std::string& what)
+{
     async_read_until(m_socket,
                      m_inputStream,
                      what,
@@ -214,6 +354,15 @@ void Connection::read_some(const RecvCallback& callback)
 
     m_recvCallback = callback;
 
+#ifdef NETWORK_THREAD
+    asio::post(g_ioService, [self = asConnection()] { self->internal_read_some(); });
+#else
+    internal_read_some();
+#endif
+}
+
+void Connection::internal_read_some()
+{
     m_socket.async_read_some(m_inputStream.prepare(RECV_BUFFER_SIZE),
                              [capture0 = asConnection()](auto&& PH1, auto&& PH2) {
         capture0->onRecv(std::forward<decltype(PH1)>(PH1), std::forward<decltype(PH2)>(PH2));
@@ -226,6 +375,38 @@ void Connection::read_some(const RecvCallback& callback)
     });
 }
 
+void Connection::read_some(uint8_t* buffer, size_t size, const RecvCallback& callback)
+{
+    if (!m_connected)
+        return;
+
+    m_recvCallback = callback;
+
+    // the callback reports sizes as 16 bits
+    size = std::min<size_t>(size, UINT16_MAX);
+
+#ifdef NETWORK_THREAD
+    asio::post(g_ioService, [self = asConnection(), buffer, size] { self->internal_read_some(buffer, size); });
+#else
+    internal_read_some(buffer, size);
+#endif
+}
+
+void Connection::internal_read_some(uint8_t* buffer, size_t size)
+{
+    m_externalInputBuffer = buffer;
+    m_socket.async_read_some(asio::buffer(buffer, size),
+                             [capture0 = asConnection()](auto&& PH1, auto&& PH2) {
+        capture0->onRecv(std::forward<decltype(PH1)>(PH1), std::forward<decltype(PH2)>(PH2));
+    });
+
+    m_readTimer.cancel();
+    m_readTimer.expires_from_now(asio::chrono::seconds(static_cast<uint32_t>(READ_TIMEOUT)));
+    m_readTimer.async_wait([capture0 = asConnection()](auto&& PH1) {
+        capture0->onTimeout(std::forward<decltype(PH1)>(PH1));
+    });
+}
+
 void Connection::onResolve(const std::error_code& error, const asio::ip::basic_resolver<asio::ip::tcp>::iterator&
                            endpointIterator)
 {
@@ -255,8 +436,15 @@ void Connection::onConnect(const std::error_code& error)
         const asio::ip::tcp::no_delay option(true);
         m_socket.set_option(option);
 
+#ifdef NETWORK_THREAD
+        postToMain([self = asConnection()] {
+            if (self->m_connectCallback)
+                self->m_connectCallback();
+        });
+#else
         if (m_connectCallback)
             m_connectCallback();
+#endif
     } else
         handleError(error);
 
@@ -274,20 +462,27 @@ void Connection::onCanWrite(const std::error_code& error)
         internal_write();
 }
 
-void Connection::onWrite(const std::error_code& error, size_t, const std::shared_ptr<asio::streambuf>&
-                         outputStream)
+void Connection::onWrite(const std::error_code& error, size_t)
 {
     m_writeTimer.cancel();
+    m_writing = false;
+
+    // give the buffers back for the next messages
+    for (auto& pending : m_activeWrites)
+        OutputMessage::releaseBuffer(std::move(pending.buffer));
+    m_activeWrites.clear();
 
     if (error == asio::error::operation_aborted)
         return;
 
-    // free output stream and store for using it again later
-    outputStream->consume(outputStream->size());
-    m_outputStreams.push_back(outputStream);
-
-    if (m_connected && error)
+    if (m_connected && error) {
         handleError(error);
+        return;
+    }
+
+    // flush whatever was queued while this write was in flight
+    if (m_connected && !m_pendingWrites.empty())
+        internal_write();
 }
 
 void Connection::onRecv(const std::error_code& error, size_t recvSize)
@@ -295,20 +490,41 @@ void Connection::onRecv(const std::error_code& error, size_t recvSize)
     m_readTimer.cancel();
     m_activityTimer.restart();
 
+    // data read into an external buffer is left where it landed
+    uint8_t* externalBuffer = m_externalInputBuffer;
+    m_externalInputBuffer = nullptr;
+
     if (error == asio::error::operation_aborted)
         return;
 
     if (m_connected) {
         if (!error) {
-            if (m_recvCallback) {
-                const auto* header = asio::buffer_cast<const char*>(m_inputStream.data());
-                m_recvCallback((uint8_t*)header, recvSize);
+            const auto* header = externalBuffer ? externalBuffer : asio::buffer_cast<const uint8_t*>(m_inputStream.data());
+#ifdef NETWORK_THREAD
+            if (m_networkRecvCallback) {
+                const RecvCallback callback = std::move(m_networkRecvCallback);
+                m_networkRecvCallback = nullptr;
+                callback((uint8_t*)header, recvSize);
+            } else if (externalBuffer) {
+                postToMain([self = asConnection(), externalBuffer, recvSize] {
+                    if (self->m_recvCallback)
+                        self->m_recvCallback(externalBuffer, recvSize);
+                });
+            } else {
+                postToMain([self = asConnection(), data = std::vector<uint8_t>(header, header + recvSize)]() mutable {
+                    if (self->m_recvCallback)
+                        self->m_recvCallback(data.data(), data.size());
+                });
             }
+#else
+            if (m_recvCallback)
+                m_recvCallback((uint8_t*)header, recvSize);
+#endif
         } else
             handleError(error);
     }
 
-    if (!error)
+    if (!error && !externalBuffer)
         m_inputStream.consume(recvSize);
 }
 
@@ -326,10 +542,26 @@ void Connection::handleError(const std::error_code& error)
         return;
 
     m_error = error;
+#ifdef NETWORK_THREAD
+    postToMain([self = asConnection(), error] {
+        if (self->m_errorCallback)
+            self->m_errorCallback(error);
+
+        // the socket is already gone, drop the callbacks so they don't keep their owners alive
+        if (!self->m_connected && !self->m_connecting) {
+            self->m_connectCallback = nullptr;
+            self->m_errorCallback = nullptr;
+            self->m_recvCallback = nullptr;
+        }
+    });
+    if (m_connected || m_connecting)
+        internal_close();
+#else
     if (m_errorCallback)
         m_errorCallback(error);
     if (m_connected || m_connecting)
         close();
+#endif
 }
 
 int Connection::getIp()
@@ -23,8 +23,10 @@
 #pragma once
 
 #include <asio/streambuf.hpp>
+#include <atomic>
 
 #include "declarations.h"
+#include "outputmessage.h"
 #include <framework/luaengine/luaobject.h>
 
 class Connection : public LuaObject
@@ -44,16 +46,34 @@ public:
     Connection();
     ~Connection() override;
 
+    static void init();
     static void poll();
     static void terminate();
 
+#ifdef NETWORK_THREAD
+    // queues a callback to be executed by the main thread on the next poll
+    static void postToMain(std::function<void()>&& callback);
+    static bool isNetworkThread();
+#endif
+
     void connect(const std::string_view host, uint16_t port, const std::function<void()>& connectCallback);
     void close();
 
     void write(uint8_t* buffer, size_t size);
+    // queues size bytes at offset of a pooled buffer without copying them, the
+    // queue is flushed with a single vectored write and the buffer goes back to the pool
+    void write(OutputMessage::BufferPtr&& buffer, uint16_t offset, uint16_t size);
     void read(uint16_t bytes, const RecvCallback& callback);
     void read_until(const std::string_view what, const RecvCallback& callback);
     void read_some(const RecvCallback& callback);
+    // reads straight into the given buffer, which must stay valid until the callback
+    void read_some(uint8_t* buffer, size_t size, const RecvCallback& callback);
+
+#ifdef NETWORK_THREAD
+    // must be called from the network thread, the callback also runs there
+    // and the buffer is only valid during the call
+    void readOnNetworkThread(uint16_t bytes, const RecvCallback& callback);
+#endif
 
     void setErrorCallback(const ErrorCallback& errorCallback) { m_errorCallback = errorCallback; }
 
@@ -66,13 +86,18 @@ public:
     ConnectionPtr asConnection() { return static_self_cast<Connection>(); }
 
 protected:
+    void internal_resolve(const std::string& host, uint16_t port);
     void internal_connect(const asio::ip::basic_resolver<asio::ip::tcp>::iterator& endpointIterator);
     void internal_write();
+    void internal_close();
+    void internal_read(uint16_t bytes);
+    void internal_read_until(const std::string& what);
+    void internal_read_some();
+    void internal_read_some(uint8_t* buffer, size_t size);
     void onResolve(const std::error_code& error, const asio::ip::tcp::resolver::iterator& endpointIterator);
     void onConnect(const std::error_code& error);
     void onCanWrite(const std::error_code& error);
-    void onWrite(const std::error_code& error, size_t writeSize, const std::shared_ptr<asio::streambuf>&
-                 outputStream);
+    void onWrite(const std::error_code& error, size_t writeSize);
     void onRecv(const std::error_code& error, size_t recvSize);
     void onTimeout(const std::error_code& error);
     void handleError(const std::error_code& error);
@@ -80,6 +105,9 @@ protected:
     std::function<void()> m_connectCallback;
     ErrorCallback m_errorCallback;
     RecvCallback m_recvCallback;
+#ifdef NETWORK_THREAD
+    RecvCallback m_networkRecvCallback;
+#endif
 
     asio::basic_waitable_timer<std::chrono::high_resolution_clock> m_readTimer;
     asio::basic_waitable_timer<std::chrono::high_resolution_clock> m_writeTimer;
@@ -87,11 +115,21 @@ protected:
     asio::ip::tcp::resolver m_resolver;
     asio::ip::tcp::socket m_socket;
 
-    static std::list<std::shared_ptr<asio::streambuf>> m_outputStreams;
-    std::shared_ptr<asio::streambuf> m_outputStream;
+    struct PendingWrite
+    {
+        OutputMessage::BufferPtr buffer;
+        uint16_t offset;
+        uint16_t size;
+    };
+
+    // writes queued during this tick, and the ones owned by the write in flight
+    std::vector<PendingWrite> m_pendingWrites;
+    std::vector<PendingWrite> m_activeWrites;
+    bool m_writing{ false };
     asio::streambuf m_inputStream;
-    bool m_connected{ false };
-    bool m_connecting{ false };
+    uint8_t* m_externalInputBuffer{ nullptr };
+    std::atomic_bool m_connected{ false };
+    std::atomic_bool m_connecting{ false };
     std::error_code m_error;
     stdext::timer m_activityTimer;
 
@@ -25,6 +25,7 @@
 
 void InputMessage::reset()
 {
+    m_buffer = m_storage;
     m_messageSize = 0;
     m_readPos = MAX_HEADER_SIZE;
     m_headerPos = MAX_HEADER_SIZE;
@@ -110,6 +111,15 @@ void InputMessage::fillBuffer(uint8_t* buffer, uint16_t size)
     m_messageSize += size;
 }
 
+void InputMessage::attachBuffer(uint8_t* frame, uint16_t size)
+{
+    // reads a frame in place, the header size must already be set and the frame
+    // must be preceded by MAX_HEADER_SIZE bytes owned by the same buffer
+    checkWrite(m_headerPos + size);
+    m_buffer = frame - m_headerPos;
+    m_messageSize = size;
+}
+
 void InputMessage::setHeaderSize(uint16_t size)
 {
     assert(MAX_HEADER_SIZE - size >= 0);
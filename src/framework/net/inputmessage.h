@@ -77,6 +77,7 @@ public:
 protected:
     void reset();
     void fillBuffer(uint8_t* buffer, uint16_t size);
+    void attachBuffer(uint8_t* frame, uint16_t size);
 
     void setHeaderSize(uint16_t size);
     void setMessageSize(uint16_t size) { m_messageSize = size; }
@@ -90,6 +91,7 @@ protected:
     bool readChecksum();
 
     friend class Protocol;
+    friend class PacketPlayer;
 
 private:
     bool canRead(int bytes);
@@ -99,5 +101,6 @@ private:
     uint16_t m_headerPos{ MAX_HEADER_SIZE };
     uint16_t m_readPos{ MAX_HEADER_SIZE };
     uint16_t m_messageSize{ 0 };
-    uint8_t m_buffer[BUFFER_MAXSIZE]{};
+    uint8_t* m_buffer{ m_storage };
+    uint8_t m_storage[BUFFER_MAXSIZE]{};
 };
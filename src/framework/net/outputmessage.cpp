@@ -23,6 +23,72 @@
 #include <framework/net/outputmessage.h>
 #include <framework/util/crypt.h>
 
+#ifdef NETWORK_THREAD
+#include <mutex>
+#endif
+
+namespace
+{
+    std::vector<OutputMessage::BufferPtr> s_bufferPool;
+#ifdef NETWORK_THREAD
+    // buffers come back from the network thread once written
+    std::mutex s_bufferPoolMutex;
+#endif
+}
+
+OutputMessage::OutputMessage() : m_storage(acquireBuffer()), m_buffer(m_storage->data()) {}
+
+OutputMessage::~OutputMessage()
+{
+    releaseBuffer(std::move(m_storage));
+}
+
+OutputMessage::BufferPtr OutputMessage::acquireBuffer()
+{
+    {
+#ifdef NETWORK_THREAD
+        std::scoped_lock lock(s_bufferPoolMutex);
+#endif
+        if (!s_bufferPool.empty()) {
+            BufferPtr buffer = std::move(s_bufferPool.back());
+            s_bufferPool.pop_back();
+            return buffer;
+        }
+    }
+
+    // left uninitialized, like the rest of the message buffers
+    return BufferPtr(new Buffer);
+}
+
+void OutputMessage::releaseBuffer(BufferPtr&& buffer)
+{
+    if (!buffer)
+        return;
+
+#ifdef NETWORK_THREAD
+    std::scoped_lock lock(s_bufferPoolMutex);
+#endif
+    if (s_bufferPool.size() < BUFFER_POOL_SIZE)
+        s_bufferPool.emplace_back(std::move(buffer));
+}
+
+void OutputMessage::clearBufferPool()
+{
+#ifdef NETWORK_THREAD
+    std::scoped_lock lock(s_bufferPoolMutex);
+#endif
+    s_bufferPool.clear();
+}
+
+OutputMessage::BufferPtr OutputMessage::detachBuffer()
+{
+    BufferPtr buffer = std::move(m_storage);
+    m_storage = acquireBuffer();
+    m_buffer = m_storage->data();
+    reset();
+    return buffer;
+}
+
 void OutputMessage::reset()
 {
     m_writePos = MAX_HEADER_SIZE;
@@ -33,9 +33,22 @@ public:
     {
         BUFFER_MAXSIZE = 65536,
         MAX_STRING_LENGTH = 65536,
-        MAX_HEADER_SIZE = 8
+        MAX_HEADER_SIZE = 8,
+        BUFFER_POOL_SIZE = 64
     };
 
+    using Buffer = std::array<uint8_t, BUFFER_MAXSIZE>;
+    using BufferPtr = std::unique_ptr<Buffer>;
+
+    OutputMessage();
+    ~OutputMessage() override;
+
+    // buffers are recycled between messages and the connection write queue,
+    // so building and sending a message does not allocate once the pool is warm
+    static BufferPtr acquireBuffer();
+    static void releaseBuffer(BufferPtr&& buffer);
+    static void clearBufferPool();
+
     void reset();
 
     void setBuffer(const std::string_view buffer);
@@ -60,6 +73,10 @@ protected:
     uint8_t* getWriteBuffer() { return m_buffer + m_writePos; }
     uint8_t* getHeaderBuffer() { return m_buffer + m_headerPos; }
     uint8_t* getDataBuffer() { return m_buffer + MAX_HEADER_SIZE; }
+    uint16_t getHeaderPos() { return m_headerPos; }
+
+    // hands the buffer over to the caller, the message continues with a fresh one
+    BufferPtr detachBuffer();
 
     void writeChecksum();
     void writeMessageSize();
@@ -73,5 +90,6 @@ private:
     uint16_t m_headerPos{ MAX_HEADER_SIZE };
     uint16_t m_writePos{ MAX_HEADER_SIZE };
     uint16_t m_messageSize{ 0 };
-    uint8_t m_buffer[BUFFER_MAXSIZE];
+    BufferPtr m_storage;
+    uint8_t* m_buffer;
 };
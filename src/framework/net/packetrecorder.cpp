@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "packetrecorder.h"
+#include "inputmessage.h"
+#include "protocol.h"
+
+#include <framework/core/clock.h>
+#include <framework/core/eventdispatcher.h>
+#include <framework/core/filestream.h>
+#include <framework/core/resourcemanager.h>
+
+namespace
+{
+    // records are gathered in memory and written in chunks of this size
+    constexpr size_t FLUSH_SIZE = 64 * 1024;
+}
+
+PacketRecorder::PacketRecorder(const FileStreamPtr& file) : m_file(file), m_startTime(g_clock.millis())
+{
+    m_buffer.reserve(FLUSH_SIZE + InputMessage::BUFFER_MAXSIZE);
+}
+
+PacketRecorder::~PacketRecorder()
+{
+    close();
+}
+
+PacketRecorderPtr PacketRecorder::create(const std::string& fileName, uint16_t clientVersion)
+{
+    try {
+        const auto file = g_resources.createFile(fileName);
+        file->addU32(MAGIC);
+        file->addU16(FORMAT_VERSION);
+        file->addU16(clientVersion);
+        return { new PacketRecorder(file) };
+    } catch (const std::exception& e) {
+        g_logger.error(stdext::format("Failed to start packet recording: %s", e.what()));
+        return {};
+    }
+}
+
+void PacketRecorder::record(Direction direction, const uint8_t* data, uint16_t size)
+{
+    if (!m_file)
+        return;
+
+    const size_t pos = m_buffer.size();
+    m_buffer.resize(pos + 7 + size);
+
+    uint8_t* out = m_buffer.data() + pos;
+    stdext::writeULE32(out, static_cast<uint32_t>(g_clock.millis() - m_startTime));
+    out[4] = direction;
+    stdext::writeULE16(out + 5, size);
+    memcpy(out + 7, data, size);
+
+    ++m_packetCount;
+    if (m_buffer.size() >= FLUSH_SIZE)
+        flush();
+}
+
+void PacketRecorder::flush()
+{
+    if (!m_file || m_buffer.empty())
+        return;
+
+    try {
+        m_file->write(m_buffer.data(), m_buffer.size());
+    } catch (const std::exception& e) {
+        g_logger.error(stdext::format("Packet recording stopped: %s", e.what()));
+        m_file = nullptr;
+    }
+    m_buffer.clear();
+}
+
+void PacketRecorder::close()
+{
+    flush();
+    if (m_file) {
+        m_file->close();
+        m_file = nullptr;
+    }
+}
+
+PacketPlayerPtr PacketPlayer::create(const std::string& fileName)
+{
+    try {
+        const auto file = g_resources.openFile(fileName);
+        file->cache();
+
+        if (file->getU32() != PacketRecorder::MAGIC)
+            throw Exception("not a packet capture");
+
+        const uint16_t formatVersion = file->getU16();
+        if (formatVersion != PacketRecorder::FORMAT_VERSION)
+            throw Exception("unsupported capture format %d", formatVersion);
+
+        const auto player = PacketPlayerPtr(new PacketPlayer);
+        player->m_clientVersion = file->getU16();
+
+        const uint32_t size = file->size();
+        while (file->tell() + 7 <= size) {
+            Packet packet;
+            packet.time = file->getU32();
+            packet.direction = static_cast<PacketRecorder::Direction>(file->getU8());
+            packet.data.resize(file->getU16());
+            file->read(packet.data.data(), packet.data.size());
+            player->m_packets.emplace_back(std::move(packet));
+        }
+
+        return player;
+    } catch (const std::exception& e) {
+        g_logger.error(stdext::format("Failed to load packet capture '%s': %s", fileName, e.what()));
+        return {};
+    }
+}
+
+void PacketPlayer::start(const ProtocolPtr& protocol, float speed)
+{
+    stop();
+
+    m_protocol = protocol;
+    m_speed = speed;
+    m_position = 0;
+    m_startTime = g_clock.millis();
+    m_inputMessage = InputMessagePtr(new InputMessage);
+
+    playNext();
+}
+
+void PacketPlayer::stop()
+{
+    if (m_nextEvent) {
+        m_nextEvent->cancel();
+        m_nextEvent = nullptr;
+    }
+    m_protocol = nullptr;
+}
+
+std::map<std::string, double> PacketPlayer::benchmark(const ProtocolPtr& protocol)
+{
+    stop();
+
+    m_protocol = protocol;
+    m_inputMessage = InputMessagePtr(new InputMessage);
+
+    // the protocol may stop the playback while handling a packet
+    const auto self = static_self_cast<PacketPlayer>();
+    double messages = 0;
+    double bytes = 0;
+
+    const uint64_t allocations = stdext::allocation_count();
+    stdext::timer timer;
+    for (m_position = 0; m_protocol && m_position < m_packets.size(); ++m_position) {
+        const Packet& packet = m_packets[m_position];
+        if (packet.direction != PacketRecorder::Inbound)
+            continue;
+
+        m_inputMessage->reset();
+        m_inputMessage->fillBuffer((uint8_t*)packet.data.data(), packet.data.size());
+        m_protocol->onRecv(m_inputMessage);
+
+        ++messages;
+        bytes += packet.data.size();
+    }
+    const double seconds = std::max<double>(timer.elapsed_micros(), 1) / 1000000.0;
+    const double allocated = stdext::allocation_count() - allocations;
+    m_protocol = nullptr;
+
+    return {
+        { "messages", messages },
+        { "bytes", bytes },
+        { "seconds", seconds },
+        { "messagesPerSecond", messages / seconds },
+        { "bytesPerSecond", bytes / seconds },
+        { "allocations", allocated },
+        { "allocationsPerMessage", messages > 0 ? allocated / messages : 0 }
+    };
+}
+
+void PacketPlayer::playNext()
+{
+    m_nextEvent = nullptr;
+
+    // the protocol may stop the playback while handling a packet
+    const auto self = static_self_cast<PacketPlayer>();
+    while (m_protocol && m_position < m_packets.size()) {
+        const Packet& packet = m_packets[m_position];
+
+        if (m_speed > 0) {
+            const auto due = m_startTime + static_cast<ticks_t>(packet.time / m_speed);
+            if (due > g_clock.millis()) {
+                m_nextEvent = g_dispatcher.scheduleEvent([self] { self->playNext(); }, due - g_clock.millis());
+                return;
+            }
+        }
+
+        ++m_position;
+        if (packet.direction != PacketRecorder::Inbound)
+            continue;
+
+        m_inputMessage->reset();
+        m_inputMessage->fillBuffer((uint8_t*)packet.data.data(), packet.data.size());
+        m_protocol->onRecv(m_inputMessage);
+    }
+
+    if (m_protocol)
+        finish();
+}
+
+void PacketPlayer::finish()
+{
+    m_protocol = nullptr;
+    callLuaField("onFinish");
+}
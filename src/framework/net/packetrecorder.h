@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "declarations.h"
+#include <framework/core/declarations.h>
+#include <framework/luaengine/luaobject.h>
+
+/*
+ * Capture file layout, all values little endian:
+ *   header: u32 magic "OTCR", u16 format version, u16 client version
+ *   record: u32 milliseconds since the capture started, u8 direction, u16 size, payload
+ * Inbound payloads are decrypted message bodies, outbound ones are taken before encryption.
+ */
+
+ // @bindclass
+class PacketRecorder : public LuaObject
+{
+public:
+    enum Direction : uint8_t
+    {
+        Inbound = 0,
+        Outbound = 1
+    };
+
+    static constexpr uint32_t MAGIC = 0x5243544F; // "OTCR"
+    static constexpr uint16_t FORMAT_VERSION = 1;
+
+    ~PacketRecorder() override;
+
+    static PacketRecorderPtr create(const std::string& fileName, uint16_t clientVersion);
+
+    void record(Direction direction, const uint8_t* data, uint16_t size);
+    void close();
+
+    bool isRecording() { return m_file != nullptr; }
+    uint32_t getPacketCount() { return m_packetCount; }
+
+private:
+    PacketRecorder(const FileStreamPtr& file);
+    void flush();
+
+    FileStreamPtr m_file;
+    std::vector<uint8_t> m_buffer;
+    ticks_t m_startTime;
+    uint32_t m_packetCount{ 0 };
+};
+
+// @bindclass
+class PacketPlayer : public LuaObject
+{
+public:
+    struct Packet
+    {
+        uint32_t time;
+        PacketRecorder::Direction direction;
+        std::string data;
+    };
+
+    static PacketPlayerPtr create(const std::string& fileName);
+
+    // feeds the inbound packets to the protocol, with speed 0 meaning as fast as possible
+    void start(const ProtocolPtr& protocol, float speed);
+    void stop();
+
+    // feeds every inbound packet at once and reports the parsing throughput
+    std::map<std::string, double> benchmark(const ProtocolPtr& protocol);
+
+    bool isPlaying() { return m_protocol != nullptr; }
+    uint16_t getClientVersion() { return m_clientVersion; }
+    uint32_t getPacketCount() { return m_packets.size(); }
+    uint32_t getPosition() { return m_position; }
+    uint32_t getDuration() { return m_packets.empty() ? 0 : m_packets.back().time; }
+
+private:
+    PacketPlayer() = default;
+
+    void playNext();
+    void finish();
+
+    std::vector<Packet> m_packets;
+    uint16_t m_clientVersion{ 0 };
+    size_t m_position{ 0 };
+    float m_speed{ 0 };
+    ticks_t m_startTime{ 0 };
+    ProtocolPtr m_protocol;
+    InputMessagePtr m_inputMessage;
+    ScheduledEventPtr m_nextEvent;
+};
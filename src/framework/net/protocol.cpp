@@ -22,9 +22,134 @@
 
 #include "protocol.h"
 #include "connection.h"
+#include "xtea.h"
 #include <framework/core/application.h>
+#include <framework/core/eventdispatcher.h>
 #include <random>
 
+#ifdef NETWORK_THREAD
+#include <asio/post.hpp>
+#include <framework/stdext/spsc_queue.h>
+
+extern asio::io_service g_ioService;
+
+struct Protocol::NetworkReader : std::enable_shared_from_this<NetworkReader>
+{
+    // bounds how many messages can be decoded ahead of the main thread
+    static constexpr size_t QUEUE_SIZE = 64;
+
+    NetworkReader(Protocol* protocol) : owner(protocol), connection(protocol->m_connection) { updateSettings(protocol); }
+
+    void start() { asio::post(g_ioService, [self = shared_from_this()] { self->readHeader(); }); }
+
+    // main thread, the settings are read again for every frame, the key is
+    // published before the flags so a frame never sees encryption without it
+    void updateSettings(const Protocol* protocol)
+    {
+        for (size_t i = 0; i < xteaKey.size(); ++i)
+            xteaKey[i].store(protocol->m_xteaKey[i], std::memory_order_relaxed);
+        compressionEnabled.store(protocol->m_compressionEnabled, std::memory_order_release);
+        checksumEnabled.store(protocol->m_checksumEnabled, std::memory_order_release);
+        xteaEncryptionEnabled.store(protocol->m_xteaEncryptionEnabled, std::memory_order_release);
+    }
+
+    // used by whichever thread is decoding, the main one only while the reader waits
+    InflateStream* getInflateStream()
+    {
+        if (!compressionEnabled.load(std::memory_order_acquire))
+            return nullptr;
+        if (!inflateStream)
+            inflateStream = std::make_unique<InflateStream>();
+        return inflateStream.get();
+    }
+
+    void readHeader()
+    {
+        if (received.full()) {
+            // the main thread resumes reading once it has drained some messages
+            stalled = true;
+            if (received.full() || !stalled.exchange(false))
+                return;
+        }
+
+        connection->readOnNetworkThread(2, [self = shared_from_this()](uint8_t* buffer, uint16_t) {
+            std::memcpy(self->sizeBuffer.data(), buffer, self->sizeBuffer.size());
+            const uint16_t remainingSize = stdext::readULE16(buffer);
+            self->connection->readOnNetworkThread(remainingSize, [self](uint8_t* buffer, uint16_t size) {
+                self->readData(buffer, size);
+            });
+        });
+    }
+
+    void readData(uint8_t* buffer, uint16_t size)
+    {
+        // settings may change between frames, e.g. encryption is enabled once the login is sent
+        const bool xteaEnabled = xteaEncryptionEnabled.load(std::memory_order_acquire);
+        const bool checksum = checksumEnabled.load(std::memory_order_acquire);
+
+        if (!recycled.pop(message))
+            message = InputMessagePtr(new InputMessage);
+
+        message->reset();
+        message->setHeaderSize(getHeaderSize(checksum, xteaEnabled));
+        message->fillBuffer(sizeBuffer.data(), sizeBuffer.size());
+        message->readSize();
+        message->fillBuffer(buffer, size);
+
+        // until encryption is enabled the protocol is still handshaking and handling this
+        // frame may change how the next ones are read, so it is passed undecoded to the
+        // main thread and reading waits for it to be handled
+        const bool raw = !xteaEnabled;
+        if (raw)
+            rawMessage.store(message.get(), std::memory_order_relaxed);
+        else {
+            std::array<uint32_t, 4> key;
+            for (size_t i = 0; i < key.size(); ++i)
+                key[i] = xteaKey[i].load(std::memory_order_relaxed);
+
+            // like the main thread path, an invalid message stops the reading
+            if (!unpackMessage(message, checksum, true, key, getInflateStream()))
+                return;
+        }
+
+        // can't fail, free space was checked before reading
+        received.push(std::move(message));
+
+        if (!notified.exchange(true)) {
+            Connection::postToMain([self = shared_from_this()] {
+                self->notified = false;
+                if (self->owner)
+                    self->owner->dispatchReceived();
+            });
+        }
+
+        if (!raw)
+            readHeader();
+    }
+
+    // main thread only
+    Protocol* owner;
+
+    const ConnectionPtr connection;
+
+    std::atomic_bool checksumEnabled{ false };
+    std::atomic_bool xteaEncryptionEnabled{ false };
+    std::atomic_bool compressionEnabled{ false };
+    std::array<std::atomic<uint32_t>, 4> xteaKey{};
+
+    // network thread only
+    InputMessagePtr message;
+    std::array<uint8_t, 2> sizeBuffer{};
+    std::unique_ptr<InflateStream> inflateStream;
+
+    stdext::spsc_queue<InputMessagePtr, QUEUE_SIZE> received;
+    stdext::spsc_queue<InputMessagePtr, QUEUE_SIZE> recycled;
+    std::atomic<InputMessage*> rawMessage{ nullptr };
+    std::atomic_bool stalled{ false };
+    std::atomic_bool notified{ false };
+};
+#endif
+
 Protocol::Protocol() :m_inputMessage(InputMessagePtr(new InputMessage)) {}
 
 Protocol::~Protocol()
@@ -37,6 +162,13 @@ Protocol::~Protocol()
 
 void Protocol::connect(const std::string_view host, uint16_t port)
 {
+#ifdef NETWORK_THREAD
+    if (m_networkReader) {
+        m_networkReader->owner = nullptr;
+        m_networkReader.reset();
+    }
+#endif
+
     m_connection = ConnectionPtr(new Connection);
     m_connection->setErrorCallback([capture0 = asProtocol()](auto&& PH1) { capture0->onError(std::forward<decltype(PH1)>(PH1));    });
     m_connection->connect(host, port, [capture0 = asProtocol()] { capture0->onConnect(); });
@@ -44,6 +176,16 @@ void Protocol::connect(const std::string_view host, uint16_t port)
 
 void Protocol::disconnect()
 {
+#ifdef NETWORK_THREAD
+    if (m_networkReader) {
+        m_networkReader->owner = nullptr;
+        m_networkReader.reset();
+    }
+#endif
+
+    m_recvPending = false;
+    m_recvBegin = m_recvEnd = InputMessage::MAX_HEADER_SIZE;
+
     if (m_connection) {
         m_connection->close();
         m_connection.reset();
@@ -52,9 +194,15 @@ void Protocol::disconnect()
 
 void Protocol::send(const OutputMessagePtr& outputMessage)
 {
+    if (m_recorder)
+        m_recorder->record(PacketRecorder::Outbound, outputMessage->getDataBuffer(), outputMessage->getMessageSize());
+
     // encrypt
-    if (m_xteaEncryptionEnabled)
+    if (m_xteaEncryptionEnabled) {
+        if (m_compressionEnabled)
+            deflateMessage(outputMessage);
         xteaEncrypt(outputMessage);
+    }
 
     // write checksum
     if (m_checksumEnabled)
@@ -63,25 +211,60 @@ void Protocol::send(const OutputMessagePtr& outputMessage)
     // write message size
     outputMessage->writeMessageSize();
 
-    // send
-    if (m_connection)
-        m_connection->write(outputMessage->getHeaderBuffer(), outputMessage->getMessageSize());
+    // send, the connection takes the buffer over instead of copying it
+    if (m_connection) {
+        const uint16_t offset = outputMessage->getHeaderPos();
+        const uint16_t size = outputMessage->getMessageSize();
+        m_connection->write(outputMessage->detachBuffer(), offset, size);
+    }
 
     // reset message to allow reuse
     outputMessage->reset();
 }
 
+uint16_t Protocol::getHeaderSize(bool checksumEnabled, bool xteaEncryptionEnabled)
+{
+    uint16_t headerSize = 2; // 2 bytes for message size
+    if (checksumEnabled)
+        headerSize += 4; // 4 bytes for checksum
+    if (xteaEncryptionEnabled)
+        headerSize += 2; // 2 bytes for XTEA encrypted message size
+    return headerSize;
+}
+
 void Protocol::recv()
 {
+#ifdef NETWORK_THREAD
+    m_recvPending = true;
+    if (!m_connection)
+        return;
+
+    if (!m_networkReader) {
+        m_networkReader = std::make_shared<NetworkReader>(this);
+        m_networkReader->start();
+    } else if (!m_dispatchingReceived && !m_networkReader->received.empty())
+        g_dispatcher.addEvent([self = asProtocol()] { self->dispatchReceived(); });
+    return;
+#endif
+
+    if (m_coalescedRecvEnabled) {
+        m_recvPending = true;
+
+        // when called from onRecv, the parsing loop takes care of it
+        if (m_dispatchingReceived)
+            return;
+
+        if (m_recvEnd > m_recvBegin)
+            g_dispatcher.addEvent([self = asProtocol()] { self->parseCoalesced(); });
+        else
+            readCoalesced();
+        return;
+    }
+
     m_inputMessage->reset();
 
     // first update message header size
-    int headerSize = 2; // 2 bytes for message size
-    if (m_checksumEnabled)
-        headerSize += 4; // 4 bytes for checksum
-    if (m_xteaEncryptionEnabled)
-        headerSize += 2; // 2 bytes for XTEA encrypted message size
-    m_inputMessage->setHeaderSize(headerSize);
+    m_inputMessage->setHeaderSize(getHeaderSize(m_checksumEnabled, m_xteaEncryptionEnabled));
 
     // read the first 2 bytes which contain the message size
     if (m_connection)
@@ -115,53 +298,267 @@ void Protocol::internalRecvData(uint8_t* buffer, uint16_t size)
 
     m_inputMessage->fillBuffer(buffer, size);
 
-    if (m_checksumEnabled && !m_inputMessage->readChecksum()) {
-        g_logger.traceError("got a network message with invalid checksum");
+    if (!unpackMessage(m_inputMessage, m_checksumEnabled, m_xteaEncryptionEnabled, m_xteaKey, m_inflateStream.get()))
         return;
+
+    recordReceived(m_inputMessage);
+    onRecv(m_inputMessage);
+}
+
+void Protocol::enableCoalescedRecv()
+{
+#ifndef NETWORK_THREAD
+    // the network thread already batches reads, see NetworkReader
+    m_coalescedRecvEnabled = true;
+
+    // room for the largest frame while another one is still incomplete
+    m_recvBuffer.resize(InputMessage::MAX_HEADER_SIZE + 2 * InputMessage::BUFFER_MAXSIZE);
+    m_recvBegin = m_recvEnd = InputMessage::MAX_HEADER_SIZE;
+#endif
+}
+
+void Protocol::readCoalesced()
+{
+    if (!m_connection)
+        return;
+
+    // frames are parsed in place, so an incomplete one is moved back to the front
+    // whenever the space left could not hold a full frame
+    if (m_recvBegin == m_recvEnd)
+        m_recvBegin = m_recvEnd = InputMessage::MAX_HEADER_SIZE;
+    else if (m_recvBuffer.size() - m_recvEnd < InputMessage::BUFFER_MAXSIZE) {
+        const size_t pending = m_recvEnd - m_recvBegin;
+        std::memmove(m_recvBuffer.data() + InputMessage::MAX_HEADER_SIZE, m_recvBuffer.data() + m_recvBegin, pending);
+        m_recvBegin = InputMessage::MAX_HEADER_SIZE;
+        m_recvEnd = m_recvBegin + pending;
     }
 
-    if (m_xteaEncryptionEnabled) {
-        if (!xteaDecrypt(m_inputMessage)) {
-            g_logger.traceError("failed to decrypt message");
+    m_connection->read_some(m_recvBuffer.data() + m_recvEnd, m_recvBuffer.size() - m_recvEnd, [capture0 = asProtocol()](auto&& PH1, auto&& PH2) {
+        capture0->internalRecvCoalesced(std::forward<decltype(PH1)>(PH1),
+                                        std::forward<decltype(PH2)>(PH2));
+    });
+}
+
+void Protocol::internalRecvCoalesced(uint8_t*, uint16_t size)
+{
+    // process data only if really connected
+    if (!isConnected()) {
+        g_logger.traceError("received data while disconnected");
+        return;
+    }
+
+    // the data was read right after what was already buffered
+    m_recvEnd += size;
+    parseCoalesced();
+}
+
+void Protocol::parseCoalesced()
+{
+    // onRecv may disconnect and release the last reference to this protocol
+    const auto self = asProtocol();
+
+    m_dispatchingReceived = true;
+    while (m_recvPending && isConnected()) {
+        const size_t available = m_recvEnd - m_recvBegin;
+        if (available < 2)
+            break;
+
+        uint8_t* frame = m_recvBuffer.data() + m_recvBegin;
+        const size_t frameSize = 2 + stdext::readULE16(frame);
+        if (frameSize > InputMessage::BUFFER_MAXSIZE - InputMessage::MAX_HEADER_SIZE) {
+            g_logger.traceError(stdext::format("got a network message of %d bytes, larger than the input buffer", static_cast<int>(frameSize)));
+            m_dispatchingReceived = false;
+            return;
+        }
+
+        if (available < frameSize)
+            break;
+
+        m_recvBegin += frameSize;
+        m_recvPending = false;
+
+        // onRecv may enable the checksum or the encryption for the next frame
+        m_inputMessage->reset();
+        m_inputMessage->setHeaderSize(getHeaderSize(m_checksumEnabled, m_xteaEncryptionEnabled));
+        try {
+            m_inputMessage->attachBuffer(frame, static_cast<uint16_t>(frameSize));
+        } catch (const stdext::exception& e) {
+            g_logger.traceError(e.what());
+            m_dispatchingReceived = false;
             return;
         }
+        m_inputMessage->readSize();
+
+        if (!unpackMessage(m_inputMessage, m_checksumEnabled, m_xteaEncryptionEnabled, m_xteaKey, m_inflateStream.get())) {
+            m_dispatchingReceived = false;
+            return;
+        }
+
+        recordReceived(m_inputMessage);
+        onRecv(m_inputMessage);
     }
-    onRecv(m_inputMessage);
+    m_dispatchingReceived = false;
+
+    if (m_recvPending && isConnected())
+        readCoalesced();
 }
 
-void Protocol::generateXteaKey()
+void Protocol::recordReceived(const InputMessagePtr& inputMessage)
 {
-    std::random_device rd;
-    std::uniform_int_distribution<uint32_t > unif;
-    std::generate(m_xteaKey.begin(), m_xteaKey.end(), [&unif, &rd] { return unif(rd); });
+    if (m_recorder)
+        m_recorder->record(PacketRecorder::Inbound, inputMessage->getReadBuffer(), inputMessage->getUnreadSize());
 }
 
-namespace
+bool Protocol::unpackMessage(const InputMessagePtr& inputMessage, bool checksumEnabled, bool xteaEncryptionEnabled, const std::array<uint32_t, 4>& xteaKey, InflateStream* inflateStream)
 {
-    constexpr uint32_t delta = 0x9E3779B9;
+    if (checksumEnabled && !inputMessage->readChecksum()) {
+        g_logger.traceError("got a network message with invalid checksum");
+        return false;
+    }
 
-    template<typename Round>
-    void apply_rounds(uint8_t* data, size_t length, Round round)
-    {
-        for (auto j = 0u; j < length; j += 8) {
-            uint32_t left = data[j + 0] | data[j + 1] << 8u | data[j + 2] << 16u | data[j + 3] << 24u,
-                right = data[j + 4] | data[j + 5] << 8u | data[j + 6] << 16u | data[j + 7] << 24u;
-
-            round(left, right);
-
-            data[j] = static_cast<uint8_t>(left);
-            data[j + 1] = static_cast<uint8_t>(left >> 8u);
-            data[j + 2] = static_cast<uint8_t>(left >> 16u);
-            data[j + 3] = static_cast<uint8_t>(left >> 24u);
-            data[j + 4] = static_cast<uint8_t>(right);
-            data[j + 5] = static_cast<uint8_t>(right >> 8u);
-            data[j + 6] = static_cast<uint8_t>(right >> 16u);
-            data[j + 7] = static_cast<uint8_t>(right >> 24u);
+    if (xteaEncryptionEnabled) {
+        if (!xteaDecrypt(inputMessage, xteaKey)) {
+            g_logger.traceError("failed to decrypt message");
+            return false;
+        }
+
+        if (inflateStream && !inflateMessage(inputMessage, *inflateStream))
+            return false;
+    }
+
+    return true;
+}
+
+void Protocol::enableCompression()
+{
+    m_compressionEnabled = true;
+    m_inflateStream = std::make_unique<InflateStream>();
+    m_deflateStream = std::make_unique<DeflateStream>();
+    updateReaderSettings();
+}
+
+void Protocol::setXteaKey(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+    m_xteaKey = { a, b, c, d };
+    updateReaderSettings();
+}
+
+void Protocol::enableXteaEncryption()
+{
+    m_xteaEncryptionEnabled = true;
+    updateReaderSettings();
+}
+
+void Protocol::enableChecksum()
+{
+    m_checksumEnabled = true;
+    updateReaderSettings();
+}
+
+void Protocol::updateReaderSettings()
+{
+#ifdef NETWORK_THREAD
+    if (m_networkReader)
+        m_networkReader->updateSettings(this);
+#endif
+}
+
+bool Protocol::inflateMessage(const InputMessagePtr& inputMessage, InflateStream& inflateStream)
+{
+    if (inputMessage->getUnreadSize() < 1) {
+        g_logger.traceError("missing compression flag in network message");
+        return false;
+    }
+
+    if (inputMessage->getU8() == 0)
+        return true;
+
+    if (!inflateStream.inflate(inputMessage->getReadBuffer(), inputMessage->getUnreadSize(),
+                               InputMessage::BUFFER_MAXSIZE - InputMessage::MAX_HEADER_SIZE))
+        return false;
+
+    // back to the message own storage, the inflated data may not fit where it was received
+    const auto& inflated = inflateStream.getOutput();
+    inputMessage->reset();
+    inputMessage->fillBuffer(const_cast<uint8_t*>(inflated.data()), inflated.size());
+    return true;
+}
+
+void Protocol::deflateMessage(const OutputMessagePtr& outputMessage)
+{
+    // tiny messages would grow, they are only flagged, and huge ones could overflow
+    // the message once deflated, which must not happen after the stream consumed them
+    static constexpr uint16_t MIN_DEFLATE_SIZE = 64;
+    static constexpr uint16_t MAX_DEFLATE_SIZE = OutputMessage::BUFFER_MAXSIZE / 2;
+
+    const std::string_view body = outputMessage->getBuffer();
+    const bool deflate = m_outboundCompressionEnabled && body.size() >= MIN_DEFLATE_SIZE && body.size() <= MAX_DEFLATE_SIZE;
+    if (deflate && m_deflateStream->deflate((const uint8_t*)body.data(), body.size(), 1)) {
+        auto& deflated = m_deflateStream->getOutput();
+        deflated[0] = 1;
+        outputMessage->setBuffer({ (const char*)deflated.data(), deflated.size() });
+        return;
+    }
+
+    m_sendBuffer.assign(1, 0);
+    m_sendBuffer.insert(m_sendBuffer.end(), body.begin(), body.end());
+    outputMessage->setBuffer({ (const char*)m_sendBuffer.data(), m_sendBuffer.size() });
+}
+
+#ifdef NETWORK_THREAD
+void Protocol::dispatchReceived()
+{
+    if (!m_networkReader)
+        return;
+
+    // onRecv may disconnect and release the last reference to this protocol
+    const auto self = asProtocol();
+    const auto reader = m_networkReader;
+
+    m_dispatchingReceived = true;
+
+    InputMessagePtr message;
+    while (m_recvPending && reader == m_networkReader && reader->received.pop(message)) {
+        m_recvPending = false;
+        if (reader->stalled.exchange(false))
+            reader->start();
+
+        // a frame read before encryption was enabled, the reader waits for it
+        const bool raw = message.get() == reader->rawMessage.load(std::memory_order_relaxed);
+        if (raw) {
+            reader->rawMessage.store(nullptr, std::memory_order_relaxed);
+            if (!unpackMessage(message, m_checksumEnabled, m_xteaEncryptionEnabled, m_xteaKey, reader->getInflateStream())) {
+                m_dispatchingReceived = false;
+                return;
+            }
         }
+
+        recordReceived(message);
+        onRecv(message);
+
+        // reuse the buffer unless lua kept a reference to it
+        if (message.is_unique())
+            reader->recycled.push(std::move(message));
+        message.reset();
+
+        // the next frame is read with whatever settings onRecv left
+        if (raw && reader == m_networkReader)
+            reader->start();
     }
+
+    m_dispatchingReceived = false;
 }
+#endif
 
-bool Protocol::xteaDecrypt(const InputMessagePtr& inputMessage)
+void Protocol::generateXteaKey()
+{
+    std::random_device rd;
+    std::uniform_int_distribution<uint32_t > unif;
+    std::generate(m_xteaKey.begin(), m_xteaKey.end(), [&unif, &rd] { return unif(rd); });
+    updateReaderSettings();
+}
+
+bool Protocol::xteaDecrypt(const InputMessagePtr& inputMessage, const std::array<uint32_t, 4>& xteaKey)
 {
     const uint16_t encryptedSize = inputMessage->getUnreadSize();
     if (encryptedSize % 8 != 0) {
@@ -169,12 +566,7 @@ bool Protocol::xteaDecrypt(const InputMessagePtr& inputMessage)
         return false;
     }
 
-    for (uint32_t i = 0, sum = delta << 5, next_sum = sum - delta; i < 32; ++i, sum = next_sum, next_sum -= delta) {
-        apply_rounds(inputMessage->getReadBuffer(), encryptedSize, [&](uint32_t& left, uint32_t& right) {
-            right -= ((left << 4 ^ left >> 5) + left) ^ (sum + m_xteaKey[(sum >> 11) & 3]);
-            left -= ((right << 4 ^ right >> 5) + right) ^ (next_sum + m_xteaKey[next_sum & 3]);
-        });
-    }
+    xtea::decrypt(inputMessage->getReadBuffer(), encryptedSize, xteaKey);
 
     const uint16_t decryptedSize = inputMessage->getU16() + 2;
     const int sizeDelta = decryptedSize - encryptedSize;
@@ -199,12 +591,7 @@ void Protocol::xteaEncrypt(const OutputMessagePtr& outputMessage)
         encryptedSize += n;
     }
 
-    for (uint32_t i = 0, sum = 0, next_sum = sum + delta; i < 32; ++i, sum = next_sum, next_sum += delta) {
-        apply_rounds(outputMessage->getDataBuffer() - 2, encryptedSize, [&](uint32_t& left, uint32_t& right) {
-            left += ((right << 4 ^ right >> 5) + right) ^ (sum + m_xteaKey[sum & 3]);
-            right += ((left << 4 ^ left >> 5) + left) ^ (next_sum + m_xteaKey[(next_sum >> 11) & 3]);
-        });
-    }
+    xtea::encrypt(outputMessage->getDataBuffer() - 2, encryptedSize, m_xteaKey);
 }
 
 void Protocol::onConnect() { callLuaField("onConnect"); }
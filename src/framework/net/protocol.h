@@ -22,10 +22,12 @@
 
 #pragma once
 
+#include "compression.h"
 #include "connection.h"
 #include "declarations.h"
 #include "inputmessage.h"
 #include "outputmessage.h"
+#include "packetrecorder.h"
 
 #include <framework/luaengine/luaobject.h>
 
@@ -47,11 +49,24 @@ public:
     void setConnection(const ConnectionPtr& connection) { m_connection = connection; }
 
     void generateXteaKey();
-    void setXteaKey(uint32_t a, uint32_t b, uint32_t c, uint32_t d) { m_xteaKey = { a, b, c, d }; }
+    void setXteaKey(uint32_t a, uint32_t b, uint32_t c, uint32_t d);
     std::vector<uint32_t > getXteaKey() { return { m_xteaKey.begin(), m_xteaKey.end() }; }
-    void enableXteaEncryption() { m_xteaEncryptionEnabled = true; }
+    void enableXteaEncryption();
 
-    void enableChecksum() { m_checksumEnabled = true; }
+    void enableChecksum();
+
+    // encrypted messages carry a leading flag byte, 1 when the rest is deflated with the
+    // connection stream
+    void enableCompression();
+    // outbound messages are deflated too, otherwise they are sent with a 0 flag
+    void setOutboundCompression(bool enable) { m_outboundCompressionEnabled = enable; }
+
+    // reads whatever the socket has into a local buffer and parses every complete frame in place
+    void enableCoalescedRecv();
+
+    // captures every decoded inbound and every outbound message, see PacketRecorder
+    void setRecorder(const PacketRecorderPtr& recorder) { m_recorder = recorder; }
+    PacketRecorderPtr getRecorder() { return m_recorder; }
 
     virtual void send(const OutputMessagePtr& outputMessage);
     virtual void recv();
@@ -69,11 +84,49 @@ private:
     void internalRecvHeader(uint8_t* buffer, uint16_t size);
     void internalRecvData(uint8_t* buffer, uint16_t size);
 
-    bool xteaDecrypt(const InputMessagePtr& inputMessage);
+    void readCoalesced();
+    void internalRecvCoalesced(uint8_t* buffer, uint16_t size);
+    void parseCoalesced();
+
+    void updateReaderSettings();
+
+    static uint16_t getHeaderSize(bool checksumEnabled, bool xteaEncryptionEnabled);
+    static bool unpackMessage(const InputMessagePtr& inputMessage, bool checksumEnabled, bool xteaEncryptionEnabled, const std::array<uint32_t, 4>& xteaKey, InflateStream* inflateStream);
+    static bool inflateMessage(const InputMessagePtr& inputMessage, InflateStream& inflateStream);
+    void deflateMessage(const OutputMessagePtr& outputMessage);
+
+    static bool xteaDecrypt(const InputMessagePtr& inputMessage, const std::array<uint32_t, 4>& xteaKey);
     void xteaEncrypt(const OutputMessagePtr& outputMessage);
 
+    void recordReceived(const InputMessagePtr& inputMessage);
+
+    friend class PacketPlayer;
+
     bool m_checksumEnabled{ false };
     bool m_xteaEncryptionEnabled{ false };
+    bool m_coalescedRecvEnabled{ false };
+    bool m_compressionEnabled{ false };
+    bool m_outboundCompressionEnabled{ false };
+    bool m_recvPending{ false };
+    bool m_dispatchingReceived{ false };
     ConnectionPtr m_connection;
     InputMessagePtr m_inputMessage;
+    PacketRecorderPtr m_recorder;
+    std::unique_ptr<InflateStream> m_inflateStream;
+    std::unique_ptr<DeflateStream> m_deflateStream;
+    std::vector<uint8_t> m_sendBuffer;
+
+    // received bytes not parsed yet, between m_recvBegin and m_recvEnd
+    std::vector<uint8_t> m_recvBuffer;
+    size_t m_recvBegin{ 0 };
+    size_t m_recvEnd{ 0 };
+
+#ifdef NETWORK_THREAD
+    // frames, verifies and decrypts messages ahead on the network thread
+    struct NetworkReader;
+
+    void dispatchReceived();
+
+    std::shared_ptr<NetworkReader> m_networkReader;
+#endif
 };
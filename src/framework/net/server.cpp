@@ -23,6 +23,10 @@
 #include "server.h"
 #include "connection.h"
 
+#ifdef NETWORK_THREAD
+#include <asio/post.hpp>
+#endif
+
 extern asio::io_service g_ioService;
 
 Server::Server(int port)
@@ -43,8 +47,16 @@ ServerPtr Server::create(int port)
 void Server::close()
 {
     m_isOpen = false;
+#ifdef NETWORK_THREAD
+    asio::post(g_ioService, [self = static_self_cast<Server>()]() mutable {
+        self->m_acceptor.cancel();
+        self->m_acceptor.close();
+        Connection::postToMain([self = std::move(self)] {});
+    });
+#else
     m_acceptor.cancel();
     m_acceptor.close();
+#endif
 }
 
 void Server::acceptNext()
@@ -52,6 +64,20 @@ void Server::acceptNext()
     const auto connection = ConnectionPtr(new Connection);
     connection->m_connecting = true;
     const auto self = static_self_cast<Server>();
+#ifdef NETWORK_THREAD
+    asio::post(g_ioService, [this, self, connection]() mutable {
+        m_acceptor.async_accept(connection->m_socket, [self = std::move(self), connection](const std::error_code& error) mutable {
+            if (!error) {
+                connection->m_connected = true;
+                connection->m_connecting = false;
+            }
+            // lua objects must be released on the main thread, so the handler hands over its references
+            Connection::postToMain([self = std::move(self), connection = std::move(connection), error] {
+                self->callLuaField("onAccept", connection, error.message(), error.value());
+            });
+        });
+    });
+#else
     m_acceptor.async_accept(connection->m_socket, [=](const std::error_code& error) {
         if (!error) {
             connection->m_connected = true;
@@ -59,4 +85,5 @@ void Server::acceptNext()
         }
         self->callLuaField("onAccept", connection, error.message(), error.value());
     });
+#endif
 }
@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "xtea.h"
+
+#include <framework/stdext/time.h>
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define XTEA_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define XTEA_TARGET_AVX2
+#else
+#define XTEA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace xtea
+{
+    namespace
+    {
+        constexpr uint32_t delta = 0x9E3779B9;
+        constexpr uint32_t rounds = 32;
+
+        // sum + key word for each half round, computed once per message
+        using Schedule = std::array<uint32_t, rounds * 2>;
+
+        Schedule encryptSchedule(const Key& key)
+        {
+            Schedule schedule;
+            for (uint32_t i = 0, sum = 0; i < rounds; ++i) {
+                schedule[i * 2] = sum + key[sum & 3];
+                sum += delta;
+                schedule[i * 2 + 1] = sum + key[(sum >> 11) & 3];
+            }
+            return schedule;
+        }
+
+        Schedule decryptSchedule(const Key& key)
+        {
+            Schedule schedule;
+            for (uint32_t i = 0, sum = delta * rounds; i < rounds; ++i) {
+                schedule[i * 2] = sum + key[(sum >> 11) & 3];
+                sum -= delta;
+                schedule[i * 2 + 1] = sum + key[sum & 3];
+            }
+            return schedule;
+        }
+
+        inline uint32_t load32(const uint8_t* p) { return p[0] | p[1] << 8u | p[2] << 16u | p[3] << 24u; }
+
+        inline void store32(uint8_t* p, uint32_t v)
+        {
+            p[0] = static_cast<uint8_t>(v);
+            p[1] = static_cast<uint8_t>(v >> 8u);
+            p[2] = static_cast<uint8_t>(v >> 16u);
+            p[3] = static_cast<uint8_t>(v >> 24u);
+        }
+
+        // all rounds of one block stay in registers before moving to the next one
+        void encryptScalar(uint8_t* data, size_t blocks, const Schedule& schedule)
+        {
+            for (size_t b = 0; b < blocks; ++b, data += 8) {
+                uint32_t left = load32(data), right = load32(data + 4);
+                for (uint32_t i = 0; i < rounds * 2; i += 2) {
+                    left += ((right << 4 ^ right >> 5) + right) ^ schedule[i];
+                    right += ((left << 4 ^ left >> 5) + left) ^ schedule[i + 1];
+                }
+                store32(data, left);
+                store32(data + 4, right);
+            }
+        }
+
+        void decryptScalar(uint8_t* data, size_t blocks, const Schedule& schedule)
+        {
+            for (size_t b = 0; b < blocks; ++b, data += 8) {
+                uint32_t left = load32(data), right = load32(data + 4);
+                for (uint32_t i = 0; i < rounds * 2; i += 2) {
+                    right -= ((left << 4 ^ left >> 5) + left) ^ schedule[i];
+                    left -= ((right << 4 ^ right >> 5) + right) ^ schedule[i + 1];
+                }
+                store32(data, left);
+                store32(data + 4, right);
+            }
+        }
+
+#ifdef XTEA_SIMD
+        // 4 blocks per iteration, lanes hold the left and right words of independent blocks
+        template<bool Encrypt>
+        size_t processSse2(uint8_t* data, size_t blocks, const Schedule& schedule)
+        {
+            size_t b = 0;
+            for (; b + 4 <= blocks; b += 4, data += 32) {
+                // [l0 r0 l1 r1] [l2 r2 l3 r3] -> [l0 l1 l2 l3] [r0 r1 r2 r3]
+                const __m128i a = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), _MM_SHUFFLE(3, 1, 2, 0));
+                const __m128i c = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)), _MM_SHUFFLE(3, 1, 2, 0));
+                __m128i left = _mm_unpacklo_epi64(a, c);
+                __m128i right = _mm_unpackhi_epi64(a, c);
+
+                for (uint32_t i = 0; i < rounds * 2; i += 2) {
+                    if constexpr (Encrypt) {
+                        left = _mm_add_epi32(left, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(right, 4), _mm_srli_epi32(right, 5)), right), _mm_set1_epi32(schedule[i])));
+                        right = _mm_add_epi32(right, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(left, 4), _mm_srli_epi32(left, 5)), left), _mm_set1_epi32(schedule[i + 1])));
+                    } else {
+                        right = _mm_sub_epi32(right, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(left, 4), _mm_srli_epi32(left, 5)), left), _mm_set1_epi32(schedule[i])));
+                        left = _mm_sub_epi32(left, _mm_xor_si128(_mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(right, 4), _mm_srli_epi32(right, 5)), right), _mm_set1_epi32(schedule[i + 1])));
+                    }
+                }
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(data), _mm_shuffle_epi32(_mm_unpacklo_epi64(left, right), _MM_SHUFFLE(3, 1, 2, 0)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(data + 16), _mm_shuffle_epi32(_mm_unpackhi_epi64(left, right), _MM_SHUFFLE(3, 1, 2, 0)));
+            }
+            return b;
+        }
+
+        // same as above with 8 blocks, the deinterleave happens per 128 bits lane
+        template<bool Encrypt>
+        XTEA_TARGET_AVX2 size_t processAvx2(uint8_t* data, size_t blocks, const Schedule& schedule)
+        {
+            size_t b = 0;
+            for (; b + 8 <= blocks; b += 8, data += 64) {
+                const __m256i a = _mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data)), _MM_SHUFFLE(3, 1, 2, 0));
+                const __m256i c = _mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32)), _MM_SHUFFLE(3, 1, 2, 0));
+                __m256i left = _mm256_unpacklo_epi64(a, c);
+                __m256i right = _mm256_unpackhi_epi64(a, c);
+
+                for (uint32_t i = 0; i < rounds * 2; i += 2) {
+                    if constexpr (Encrypt) {
+                        left = _mm256_add_epi32(left, _mm256_xor_si256(_mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(right, 4), _mm256_srli_epi32(right, 5)), right), _mm256_set1_epi32(schedule[i])));
+                        right = _mm256_add_epi32(right, _mm256_xor_si256(_mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(left, 4), _mm256_srli_epi32(left, 5)), left), _mm256_set1_epi32(schedule[i + 1])));
+                    } else {
+                        right = _mm256_sub_epi32(right, _mm256_xor_si256(_mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(left, 4), _mm256_srli_epi32(left, 5)), left), _mm256_set1_epi32(schedule[i])));
+                        left = _mm256_sub_epi32(left, _mm256_xor_si256(_mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(right, 4), _mm256_srli_epi32(right, 5)), right), _mm256_set1_epi32(schedule[i + 1])));
+                    }
+                }
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), _mm256_shuffle_epi32(_mm256_unpacklo_epi64(left, right), _MM_SHUFFLE(3, 1, 2, 0)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + 32), _mm256_shuffle_epi32(_mm256_unpackhi_epi64(left, right), _MM_SHUFFLE(3, 1, 2, 0)));
+            }
+            return b;
+        }
+
+        bool hasAvx2()
+        {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7)
+                return false;
+
+            // the os must also save the ymm registers
+            __cpuid(info, 1);
+            if (!(info[2] & (1 << 27)) || (_xgetbv(0) & 6) != 6)
+                return false;
+
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+
+        enum class Kernel { Scalar, Sse2, Avx2 };
+
+        Kernel detectKernel()
+        {
+#ifdef XTEA_SIMD
+            return hasAvx2() ? Kernel::Avx2 : Kernel::Sse2;
+#else
+            return Kernel::Scalar;
+#endif
+        }
+
+        const Kernel kernel = detectKernel();
+
+        const char* getKernelName(const Kernel kernel)
+        {
+            switch (kernel) {
+                case Kernel::Avx2: return "avx2";
+                case Kernel::Sse2: return "sse2";
+                default: return "scalar";
+            }
+        }
+
+        // kernels can be forced below the detected one, the benchmark compares them
+        template<bool Encrypt>
+        void process(const Kernel use, uint8_t* data, size_t length, const Schedule& schedule)
+        {
+            const size_t blocks = length / 8;
+            size_t done = 0;
+
+#ifdef XTEA_SIMD
+            if (use == Kernel::Avx2)
+                done = processAvx2<Encrypt>(data, blocks, schedule);
+            if (use != Kernel::Scalar)
+                done += processSse2<Encrypt>(data + done * 8, blocks - done, schedule);
+#endif
+
+            if constexpr (Encrypt)
+                encryptScalar(data + done * 8, blocks - done, schedule);
+            else
+                decryptScalar(data + done * 8, blocks - done, schedule);
+        }
+    }
+
+    void encrypt(uint8_t* data, size_t length, const Key& key) { process<true>(kernel, data, length, encryptSchedule(key)); }
+    void decrypt(uint8_t* data, size_t length, const Key& key) { process<false>(kernel, data, length, decryptSchedule(key)); }
+
+    const char* getKernelName() { return getKernelName(kernel); }
+
+    std::map<std::string, double> benchmark(size_t length, uint32_t iterations)
+    {
+        length = std::max<size_t>(length / 8, 1) * 8;
+        iterations = std::max<uint32_t>(iterations, 1);
+
+        const Key key{ 0x01234567, 0x89ABCDEF, 0xFEDCBA98, 0x76543210 };
+        const auto encryption = encryptSchedule(key);
+        const auto decryption = decryptSchedule(key);
+
+        std::vector<uint8_t> input(length);
+        for (size_t i = 0; i < length; ++i)
+            input[i] = static_cast<uint8_t>(i * 131 + 7);
+
+        auto reference = input;
+        process<true>(Kernel::Scalar, reference.data(), length, encryption);
+
+        std::map<std::string, double> result;
+        bool roundTrip = true;
+        for (const auto use : { Kernel::Scalar, Kernel::Sse2, Kernel::Avx2 }) {
+            if (use > kernel)
+                break;
+
+            auto buffer = input;
+            process<true>(use, buffer.data(), length, encryption);
+            roundTrip = roundTrip && buffer == reference;
+
+            stdext::timer timer;
+            for (uint32_t i = 0; i < iterations; ++i) {
+                process<false>(use, buffer.data(), length, decryption);
+                process<true>(use, buffer.data(), length, encryption);
+            }
+            const double seconds = std::max<double>(timer.elapsed_micros(), 1) / 1000000.0;
+
+            process<false>(use, buffer.data(), length, decryption);
+            roundTrip = roundTrip && buffer == input;
+
+            result[std::string(getKernelName(use)) + "MBps"] = 2.0 * length * iterations / (1024 * 1024) / seconds;
+        }
+
+        result["roundTrip"] = roundTrip ? 1 : 0;
+        result["bytes"] = static_cast<double>(length);
+        result["iterations"] = iterations;
+        return result;
+    }
+}
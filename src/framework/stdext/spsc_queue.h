@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <utility>
+
+namespace stdext
+{
+    // Bounded lock-free queue for exactly one producer thread and one consumer thread.
+    // One slot is kept empty to tell a full queue from an empty one.
+    template<typename T, size_t Capacity>
+    class spsc_queue
+    {
+        static_assert(Capacity >= 2, "spsc_queue needs at least two slots");
+
+    public:
+        // producer side
+        bool push(T&& value)
+        {
+            const size_t tail = m_tail.load(std::memory_order_relaxed);
+            const size_t next = (tail + 1) % Capacity;
+            if (next == m_head.load(std::memory_order_acquire))
+                return false;
+
+            m_data[tail] = std::move(value);
+            m_tail.store(next, std::memory_order_release);
+            return true;
+        }
+
+        // consumer side
+        bool pop(T& value)
+        {
+            const size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire))
+                return false;
+
+            value = std::move(m_data[head]);
+            m_data[head] = T{};
+            m_head.store((head + 1) % Capacity, std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+        bool full() const { return (m_tail.load(std::memory_order_acquire) + 1) % Capacity == m_head.load(std::memory_order_acquire); }
+
+    private:
+        std::array<T, Capacity> m_data{};
+        alignas(64) std::atomic<size_t> m_head{ 0 };
+        alignas(64) std::atomic<size_t> m_tail{ 0 };
+    };
+}
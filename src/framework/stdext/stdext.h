@@ -29,6 +29,7 @@
 
 #include "types.h"
 
+#include "allocation.h"
 #include "cast.h"
 #include "compiler.h"
 #include "demangle.h"
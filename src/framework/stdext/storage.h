@@ -24,6 +24,9 @@
 
 #include "../pch.h"
 
+#include <any>
+#include <variant>
+
 namespace stdext
 {
     template <class K, class V,
@@ -41,24 +44,130 @@ namespace stdext
     template<typename T>
     concept OnlyEnum = std::is_enum<T>::value;
 
+    // keeps only the attributes that were set, as key/value pairs sorted by key;
+    // integers, enums, floats and strings live in typed slots, other types are boxed.
+    // The first INLINE_SIZE pairs are stored in the object, more move all of them to the heap
     template<OnlyEnum Key, uint8_t _Size = UINT8_MAX>
     class small_dynamic_storage
     {
     public:
         template<typename T>
-        T get(const Key k) const { return has(k) ? std::any_cast<T>(m_data[k]) : T{}; }
+        T get(const Key k) const
+        {
+            const Entry* it = find(k);
+            if (it == end() || it->first != k)
+                return T{};
+
+            const Value& value = it->second;
+            if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+                if (const auto* v = std::get_if<int64_t>(&value))
+                    return static_cast<T>(*v);
+            } else if constexpr (std::is_floating_point_v<T>) {
+                if (const auto* v = std::get_if<double>(&value))
+                    return static_cast<T>(*v);
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                if (const auto* v = std::get_if<std::string>(&value))
+                    return *v;
+            } else if (const auto* v = std::get_if<std::any>(&value)) {
+                if (const auto* boxed = std::any_cast<T>(v))
+                    return *boxed;
+            }
+
+            return T{};
+        }
 
         template<typename T>
-        void set(const Key k, const T& value) { m_data[k] = value; }
+        void set(const Key k, const T& value)
+        {
+            assert(static_cast<size_t>(k) < _Size);
+
+            Entry* it = find(k);
+            if (it == end() || it->first != k)
+                it = insert(it, k);
+
+            if constexpr (std::is_integral_v<T> || std::is_enum_v<T>)
+                it->second.template emplace<int64_t>(static_cast<int64_t>(value));
+            else if constexpr (std::is_floating_point_v<T>)
+                it->second.template emplace<double>(value);
+            else if constexpr (std::is_constructible_v<std::string, const T&>)
+                it->second.template emplace<std::string>(value); // views and pointers are copied, never kept
+            else
+                it->second.template emplace<std::any>(value);
+        }
 
-        void remove(const Key k) { m_data[k].reset(); }
-        void clear() { m_data.clear(); }
+        void remove(const Key k)
+        {
+            Entry* it = find(k);
+            if (it != end() && it->first == k)
+                erase(it);
+        }
+
+        void clear()
+        {
+            m_heap = {};
+            for (uint8_t i = 0; i < m_inlineSize; ++i)
+                m_inline[i].second = Value{};
+            m_inlineSize = 0;
+        }
 
-        bool has(const Key k) const { return static_cast<uint8_t>(m_data.size()) >= k && m_data[k].has_value(); }
-        size_t size() const { return m_data.size(); }
+        bool has(const Key k) const
+        {
+            const Entry* it = find(k);
+            return it != end() && it->first == k;
+        }
+        size_t size() const { return m_heap.empty() ? m_inlineSize : m_heap.size(); }
 
     private:
-        std::array<std::any, _Size> m_data{};
+        using Value = std::variant<int64_t, double, std::string, std::any>;
+        using Entry = std::pair<Key, Value>;
+
+        static constexpr uint8_t INLINE_SIZE = 4;
+
+        Entry* begin() { return m_heap.empty() ? m_inline.data() : m_heap.data(); }
+        const Entry* begin() const { return m_heap.empty() ? m_inline.data() : m_heap.data(); }
+        Entry* end() { return begin() + size(); }
+        const Entry* end() const { return begin() + size(); }
+
+        Entry* find(const Key k) { return std::lower_bound(begin(), end(), k, [](const Entry& entry, const Key key) { return entry.first < key; }); }
+        const Entry* find(const Key k) const { return std::lower_bound(begin(), end(), k, [](const Entry& entry, const Key key) { return entry.first < key; }); }
+
+        Entry* insert(Entry* pos, const Key k)
+        {
+            if (m_heap.empty() && m_inlineSize < INLINE_SIZE) {
+                std::move_backward(pos, m_inline.data() + m_inlineSize, m_inline.data() + m_inlineSize + 1);
+                ++m_inlineSize;
+                *pos = Entry{ k, Value{} };
+                return pos;
+            }
+
+            if (m_heap.empty()) {
+                const size_t index = pos - m_inline.data();
+                m_heap.reserve(INLINE_SIZE * 2);
+                for (uint8_t i = 0; i < m_inlineSize; ++i) {
+                    m_heap.emplace_back(std::move(m_inline[i]));
+                    m_inline[i].second = Value{};
+                }
+                m_inlineSize = 0;
+                pos = m_heap.data() + index;
+            }
+
+            return &*m_heap.emplace(m_heap.begin() + (pos - m_heap.data()), k, Value{});
+        }
+
+        void erase(Entry* pos)
+        {
+            if (!m_heap.empty()) {
+                m_heap.erase(m_heap.begin() + (pos - m_heap.data()));
+                return;
+            }
+
+            std::move(pos + 1, m_inline.data() + m_inlineSize, pos);
+            m_inline[--m_inlineSize].second = Value{};
+        }
+
+        std::array<Entry, INLINE_SIZE> m_inline{};
+        std::vector<Entry> m_heap;
+        uint8_t m_inlineSize{ 0 };
     };
 
     template<OnlyEnum Key>
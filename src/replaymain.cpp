@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <client/client.h>
+#include <client/game.h>
+#include <client/opcodestats.h>
+#include <client/thingtypemanager.h>
+#include <framework/core/application.h>
+#include <framework/core/asyncdispatcher.h>
+#include <framework/core/eventdispatcher.h>
+#include <framework/core/resourcemanager.h>
+#include <framework/net/packetrecorder.h>
+
+// Replays a session captured by PacketRecorder through the game protocol as fast as
+// possible and prints the parse throughput, see Game::benchmarkRecording.
+// Only the framework core is initialized, there is no window and no graphics context.
+int main(int argc, const char* argv[])
+{
+    std::vector<std::string> args(argv, argv + argc);
+    if (args.size() < 2) {
+        std::cerr << "usage: " << args[0] << " <recording> [iterations]" << std::endl;
+        return 1;
+    }
+
+    g_app.setName("OTClient - Redemption");
+    g_app.setCompactName("otclient");
+    g_app.setOrganizationName("otbr");
+
+    // the graphical application init would create the window
+    g_app.Application::init(args);
+    Client::initCore();
+
+    // same search paths as init.lua, the recording and the things are looked up in them
+    if (!g_resources.discoverWorkDir("init.lua"))
+        g_logger.fatal("Unable to find work directory, the replay cannot be initialized.");
+
+    if (!g_resources.addSearchPath(g_resources.getWorkDir() + "data", true))
+        g_logger.fatal("Unable to add data directory to the search path.");
+
+    if (!g_resources.addSearchPath(g_resources.getWorkDir() + "modules", true))
+        g_logger.fatal("Unable to add modules directory to the search path.");
+
+    g_resources.addSearchPath(g_resources.getWorkDir() + "mods", true);
+    g_resources.setupUserWriteDir(stdext::format("%s/", g_app.getCompactName()));
+    g_resources.searchAndAddPackages("/", ".otpkg");
+
+    std::map<std::string, double> results;
+    try {
+        const auto& player = PacketPlayer::create(args[1]);
+        if (!player)
+            throw Exception("unable to load recording %s", args[1]);
+
+        const int version = player->getClientVersion();
+        g_game.setClientVersion(version);
+        g_game.setProtocolVersion(version);
+
+        // sprites are not needed to parse, only the thing types
+        const bool loaded = version >= 1281
+            ? g_things.loadAppearances(stdext::format("/things/%d/catalog-content", version))
+            : g_things.loadDat(stdext::format("/things/%d/Tibia", version));
+        if (!loaded)
+            throw Exception("unable to load things for client version %d", version);
+
+        // the throughput includes the cost of measuring every opcode
+        g_opcodeStats.reset();
+        g_opcodeStats.setEnabled(true);
+
+        const int iterations = args.size() >= 3 ? stdext::from_string<int>(args[2], 1) : 1;
+        results = g_game.benchmarkRecording(args[1], iterations);
+        for (const auto& [name, value] : results)
+            std::cout << name << ": " << value << std::endl;
+
+        std::cout << std::endl << g_opcodeStats.dump(0);
+    } catch (const stdext::exception& e) {
+        g_logger.error(stdext::format("replay failed: %s", e.what()));
+    }
+
+    // Application::deinit would poll the window, release only what the core started
+    g_asyncDispatcher.terminate();
+    g_dispatcher.shutdown();
+
+    Client::terminate();
+    g_app.Application::terminate();
+    return results.empty() ? 1 : 0;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <framework/stdext/storage.h>
+
+namespace
+{
+    enum TestAttr : uint8_t
+    {
+        TestAttrName,
+        TestAttrDescription,
+        TestAttrLast
+    };
+
+    int failures = 0;
+
+    void check(bool passed, const std::string_view what)
+    {
+        if (passed)
+            return;
+
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+int main()
+{
+    stdext::small_dynamic_storage<TestAttr, TestAttrLast> storage;
+
+    {
+        // the caller's buffer is overwritten and released right after the set
+        std::string name = "house name";
+        storage.set(TestAttrName, std::string_view{ name });
+        name.assign(name.size(), 'x');
+    }
+    check(storage.get<std::string>(TestAttrName) == "house name", "a string_view value is stored as an owned string");
+
+    {
+        char description[] = "description";
+        storage.set(TestAttrDescription, static_cast<const char*>(description));
+        description[0] = 'X';
+    }
+    check(storage.get<std::string>(TestAttrDescription) == "description", "a const char* value is stored as an owned string");
+
+    storage.set(TestAttrName, "literal");
+    check(storage.get<std::string>(TestAttrName) == "literal", "a string literal replaces the previous value");
+    check(storage.size() == 2, "replacing a value keeps one entry per key");
+
+    {
+        // out of order and past the pairs kept in the object, then back below them
+        stdext::small_dynamic_storage<TestAttr> numbers;
+        const int keys[] = { 9, 3, 7, 1, 5, 8, 2 };
+        for (const int key : keys)
+            numbers.set(static_cast<TestAttr>(key), key * 10);
+
+        bool found = numbers.size() == std::size(keys);
+        for (const int key : keys)
+            found = found && numbers.get<int>(static_cast<TestAttr>(key)) == key * 10;
+        check(found, "values are kept past the inline pairs");
+
+        for (const int key : { 9, 3, 7, 1, 5 })
+            numbers.remove(static_cast<TestAttr>(key));
+        check(numbers.size() == 2 && numbers.get<int>(static_cast<TestAttr>(8)) == 80 && numbers.get<int>(static_cast<TestAttr>(2)) == 20
+              && !numbers.has(static_cast<TestAttr>(9)), "removing pairs keeps the others");
+
+        numbers.clear();
+        numbers.set(static_cast<TestAttr>(4), 40);
+        check(numbers.size() == 1 && numbers.get<int>(static_cast<TestAttr>(4)) == 40, "a cleared storage is reusable");
+    }
+
+    return failures == 0 ? 0 : 1;
+}